@@ -57,6 +57,12 @@ constexpr auto kNoUpdatesTimeout = 60 * 1000;
 // If nothing is received in 1 min when was a sleepmode we ping.
 constexpr auto kNoUpdatesAfterSleepTimeout = 60 * crl::time(1000);
 
+// Channels not open or pinned wait for one of those requests to finish.
+constexpr auto kChannelDifferenceRequestsLimit = 8;
+
+// Applying a difference for that long blocks the interface noticeably.
+constexpr auto kSlowDifferenceApply = crl::time(100);
+
 enum class DataIsLoadedResult {
 	NotLoaded = 0,
 	FromNotLoaded = 1,
@@ -352,6 +358,7 @@ void Updates::channelDifferenceDone(
 		not_null<ChannelData*> channel,
 		const MTPupdates_ChannelDifference &difference) {
 	_channelFailDifferenceTimeout.remove(channel);
+	_channelDifferenceRequests.remove(channel);
 
 	const auto timeout = difference.match([&](const auto &data) {
 		return data.vtimeout().value_or_empty();
@@ -400,10 +407,42 @@ void Updates::channelDifferenceDone(
 			? (timeout * crl::time(1000))
 			: kWaitForChannelGetDifference);
 	}
+	sendQueuedChannelDifferences();
+}
+
+bool Updates::channelDifferencePrioritized(
+		not_null<ChannelData*> channel) const {
+	if (ranges::contains(
+			_activeChats,
+			channel,
+			[](const auto &pair) { return pair.second.peer; })) {
+		return true;
+	}
+	const auto history = session().data().historyLoaded(channel);
+	return history && history->isPinnedDialog(FilterId());
+}
+
+void Updates::sendQueuedChannelDifferences() {
+	while (!_channelDifferenceQueue.empty()
+		&& (int(_channelDifferenceRequests.size())
+			< kChannelDifferenceRequestsLimit)) {
+		const auto [next, from] = _channelDifferenceQueue.front();
+		_channelDifferenceQueue.pop_front();
+		getChannelDifference(next, from);
+	}
+	if (_channelCatchUpStarted && _channelDifferenceQueue.empty()) {
+		LOG(("Updates: Channels catch up finished in %1 ms."
+			).arg(crl::now() - _channelCatchUpStarted));
+		_channelCatchUpStarted = 0;
+	} else if (!_channelDifferenceQueue.empty()) {
+		DEBUG_LOG(("Updates: Channels catch up, %1 channels left."
+			).arg(_channelDifferenceQueue.size()));
+	}
 }
 
 void Updates::feedChannelDifference(
 		const MTPDupdates_channelDifference &data) {
+	const auto started = crl::now();
 	session().data().processUsers(data.vusers());
 	session().data().processChats(data.vchats());
 
@@ -416,6 +455,36 @@ void Updates::feedChannelDifference(
 		data.vother_updates(),
 		SkipUpdatePolicy::SkipMessageIds);
 	_handlingChannelDifference = false;
+
+	logDifferenceApplied(
+		data.vnew_messages().v.size(),
+		data.vother_updates().v.size(),
+		started);
+}
+
+void Updates::logDifferenceApplied(
+		int messages,
+		int updates,
+		crl::time started) const {
+	const auto duration = crl::now() - started;
+	const auto count = messages + updates;
+	const auto perSecond = duration
+		? (count * crl::time(1000) / duration)
+		: crl::time(count * 1000);
+	if (duration >= kSlowDifferenceApply) {
+		LOG(("Updates: Slow difference apply, "
+			"%1 messages and %2 updates in %3 ms (%4 per second)."
+			).arg(messages
+			).arg(updates
+			).arg(duration
+			).arg(perSecond));
+	} else {
+		DEBUG_LOG(("Updates: Difference applied, "
+			"%1 messages and %2 updates in %3 ms."
+			).arg(messages
+			).arg(updates
+			).arg(duration));
+	}
 }
 
 void Updates::channelDifferenceFail(
@@ -425,7 +494,9 @@ void Updates::channelDifferenceFail(
 		QString::number(error.code()),
 		error.type(),
 		error.description()));
+	_channelDifferenceRequests.remove(channel);
 	failDifferenceStartTimerFor(channel);
+	sendQueuedChannelDifferences();
 }
 
 void Updates::stateDone(const MTPupdates_State &state) {
@@ -571,11 +642,13 @@ void Updates::feedDifference(
 		const MTPVector<MTPMessage> &msgs,
 		const MTPVector<MTPUpdate> &other) {
 	Core::App().checkAutoLock();
+	const auto started = crl::now();
 	session().data().processUsers(users);
 	session().data().processChats(chats);
 	feedMessageIds(other);
 	session().data().processMessages(msgs, NewMessageType::Unread);
 	feedUpdateVector(other, SkipUpdatePolicy::SkipMessageIds);
+	logDifferenceApplied(msgs.v.size(), other.v.size(), started);
 }
 
 void Updates::differenceFail(const MTP::Error &error) {
@@ -683,6 +756,22 @@ void Updates::getChannelDifference(
 		_whenGetDiffAfterFail.remove(channel);
 	}
 
+	if ((int(_channelDifferenceRequests.size())
+			>= kChannelDifferenceRequestsLimit)
+		&& !channelDifferencePrioritized(channel)) {
+		const auto queued = ranges::contains(
+			_channelDifferenceQueue,
+			channel,
+			[](const auto &pair) { return pair.first; });
+		if (!queued) {
+			if (_channelDifferenceQueue.empty() && !_channelCatchUpStarted) {
+				_channelCatchUpStarted = crl::now();
+			}
+			_channelDifferenceQueue.emplace_back(channel, from);
+		}
+		return;
+	}
+	_channelDifferenceRequests.emplace(channel);
 	channel->ptsSetRequesting(true);
 
 	auto filter = MTP_channelMessagesFilterEmpty();
@@ -114,7 +114,14 @@ private:
 		not_null<ChannelData*> channel,
 		const MTP::Error &error);
 	void failDifferenceStartTimerFor(ChannelData *channel);
+	[[nodiscard]] bool channelDifferencePrioritized(
+		not_null<ChannelData*> channel) const;
+	void sendQueuedChannelDifferences();
 	void feedChannelDifference(const MTPDupdates_channelDifference &data);
+	void logDifferenceApplied(
+		int messages,
+		int updates,
+		crl::time started) const;
 
 	void mtpUpdateReceived(const MTPUpdates &updates);
 	void mtpNewSessionCreated();
@@ -174,6 +181,14 @@ private:
 		not_null<ChannelData*>,
 		mtpRequestId> _rangeDifferenceRequests;
 
+	// After a wake up many channels need a difference at once, requests
+	// for chats not open or pinned are sent in a limited window.
+	base::flat_set<not_null<ChannelData*>> _channelDifferenceRequests;
+	std::deque<std::pair<
+		not_null<ChannelData*>,
+		ChannelDifferenceRequest>> _channelDifferenceQueue;
+	crl::time _channelCatchUpStarted = 0;
+
 	crl::time _lastUpdateTime = 0;
 	bool _handlingChannelDifference = false;
 
@@ -1852,17 +1852,20 @@ void ApiWrap::scheduleStickerSetRequest(uint64 setId, uint64 access) {
 }
 
 void ApiWrap::requestStickerSets() {
-	for (auto i = _stickerSetRequests.begin(), j = i, e = _stickerSetRequests.end(); i != e; i = j) {
-		++j;
+	// Sticker panels are refreshed once, after all the sets are received.
+	auto batch = MTP::Sender::Batch(this, [=] {
+		_session->data().stickers().notifyUpdated();
+	});
+	for (auto i = _stickerSetRequests.begin(), e = _stickerSetRequests.end(); i != e; ++i) {
 		if (i.value().second) continue;
 
-		auto waitMs = (j == e) ? 0 : kSmallDelayMs;
 		i.value().second = request(MTPmessages_GetStickerSet(MTP_inputStickerSetID(MTP_long(i.key()), MTP_long(i.value().first)))).done([this, setId = i.key()](const MTPmessages_StickerSet &result) {
 			gotStickerSet(setId, result);
 		}).fail([this, setId = i.key()](const MTP::Error &error) {
 			_stickerSetRequests.remove(setId);
-		}).afterDelay(waitMs).send();
+		}).inBatch(batch).send();
 	}
+	batch.send();
 }
 
 void ApiWrap::saveStickerSets(
@@ -2593,7 +2596,7 @@ void ApiWrap::applyNotifySettings(
 
 void ApiWrap::gotStickerSet(uint64 setId, const MTPmessages_StickerSet &result) {
 	_stickerSetRequests.remove(setId);
-	_session->data().stickers().feedSetFull(result);
+	_session->data().stickers().applySetFull(result);
 }
 
 void ApiWrap::requestWebPageDelayed(WebPageData *page) {
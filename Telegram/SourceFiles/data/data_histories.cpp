@@ -11,12 +11,15 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_channel.h"
 #include "data/data_chat.h"
 #include "data/data_folder.h"
+#include "data/data_peer_id.h"
 #include "data/data_scheduled_messages.h"
 #include "main/main_session.h"
 #include "window/notifications_manager.h"
 #include "history/history.h"
 #include "history/history_item.h"
 #include "history/view/history_view_element.h"
+#include "storage/cache/storage_cache_database.h"
+#include "storage/file_download.h"
 #include "core/application.h"
 #include "apiwrap.h"
 
@@ -24,6 +27,60 @@ namespace Data {
 namespace {
 
 constexpr auto kReadRequestTimeout = 3 * crl::time(1000);
+constexpr auto kClosedLoadedViewsLimit = 10000;
+constexpr auto kUnloadClosedOnNewMessages = 50;
+constexpr auto kCachedSliceKeyTag = uint64(0x0100000000000000ULL);
+
+[[nodiscard]] Storage::Cache::Key CachedSliceKey(PeerId peerId) {
+	return Storage::Cache::Key{ kCachedSliceKeyTag, peerId.value };
+}
+
+[[nodiscard]] QByteArray SerializeSlice(const MTPmessages_Messages &slice) {
+	auto buffer = mtpBuffer();
+	buffer.reserve(slice.innerLength() / sizeof(mtpPrime));
+	slice.write(buffer);
+	return QByteArray(
+		reinterpret_cast<const char*>(buffer.data()),
+		buffer.size() * sizeof(mtpPrime));
+}
+
+[[nodiscard]] std::optional<MTPmessages_Messages> DeserializeSlice(
+		const QByteArray &serialized) {
+	if (serialized.isEmpty() || (serialized.size() % sizeof(mtpPrime))) {
+		return std::nullopt;
+	}
+	auto from = reinterpret_cast<const mtpPrime*>(serialized.constData());
+	const auto end = from + (serialized.size() / sizeof(mtpPrime));
+	auto result = MTPmessages_Messages();
+	if (!result.read(from, end) || from != end) {
+		return std::nullopt;
+	}
+	return result;
+}
+
+[[nodiscard]] PeerId PeerFromUser(const MTPUser &user) {
+	return user.match([](const auto &data) {
+		return peerFromUser(data.vid());
+	});
+}
+
+[[nodiscard]] PeerId PeerFromChat(const MTPChat &chat) {
+	return chat.match([](const MTPDchannel &data) {
+		return peerFromChannel(data.vid());
+	}, [](const MTPDchannelForbidden &data) {
+		return peerFromChannel(data.vid());
+	}, [](const auto &data) {
+		return peerFromChat(data.vid());
+	});
+}
+
+[[nodiscard]] int LoadedViewsCount(not_null<History*> history) {
+	auto result = 0;
+	for (const auto &block : history->blocks) {
+		result += int(block->messages.size());
+	}
+	return result;
+}
 
 } // namespace
 
@@ -58,15 +115,108 @@ not_null<History*> Histories::findOrCreate(PeerId peerId) {
 }
 
 void Histories::unloadAll() {
+	_closedLoaded.clear();
 	for (const auto &[peerId, history] : _map) {
 		history->clear(History::ClearType::Unload);
 	}
 }
 
 void Histories::clearAll() {
+	_closedLoaded.clear();
 	_map.clear();
 }
 
+void Histories::historyOpened(not_null<History*> history) {
+	_closedLoaded.erase(
+		ranges::remove(_closedLoaded, history),
+		end(_closedLoaded));
+}
+
+void Histories::historyClosed(not_null<History*> history) {
+	historyOpened(history);
+	if (!history->isEmpty()) {
+		_closedLoaded.push_back(history);
+		checkClosedLoadedLimit();
+	}
+}
+
+auto Histories::loadedViews() const -> std::vector<LoadedViews> {
+	auto result = std::vector<LoadedViews>();
+	for (const auto &[peerId, history] : _map) {
+		if (const auto count = LoadedViewsCount(history.get())) {
+			result.push_back({
+				.history = history.get(),
+				.count = count,
+				.closed = ranges::contains(
+					_closedLoaded,
+					not_null(history.get())),
+			});
+		}
+	}
+	ranges::sort(result, std::greater<>(), &LoadedViews::count);
+	return result;
+}
+
+void Histories::prepareForNewMessages(const QVector<MTPMessage> &messages) {
+	if (_closedLoaded.empty()
+		|| messages.size() < kUnloadClosedOnNewMessages) {
+		return;
+	}
+	auto counts = base::flat_map<PeerId, int>();
+	for (const auto &message : messages) {
+		if (const auto peerId = PeerFromMessage(message)) {
+			++counts[peerId];
+		}
+	}
+	for (const auto &[peerId, count] : counts) {
+		if (count < kUnloadClosedOnNewMessages) {
+			continue;
+		}
+		const auto history = find(peerId);
+		if (!history) {
+			continue;
+		}
+		const auto i = ranges::find(_closedLoaded, not_null(history));
+		if (i == end(_closedLoaded)) {
+			continue;
+		}
+		DEBUG_LOG(("Histories: Unloading closed %1 before adding %2 "
+			"new messages."
+			).arg(peerId.value
+			).arg(count));
+		_closedLoaded.erase(i);
+		history->clear(History::ClearType::Unload);
+	}
+}
+
+void Histories::checkClosedLoadedLimit() {
+	auto counts = std::vector<int>();
+	counts.reserve(_closedLoaded.size());
+	auto total = 0;
+	for (const auto history : _closedLoaded) {
+		counts.push_back(LoadedViewsCount(history));
+		total += counts.back();
+	}
+	auto unloaded = 0;
+
+	// Always keep the last closed history, it is likely to be reopened.
+	while (total > kClosedLoadedViewsLimit
+		&& unloaded + 1 < int(_closedLoaded.size())) {
+		const auto history = _closedLoaded[unloaded];
+		const auto count = counts[unloaded++];
+		DEBUG_LOG(("Histories: Unloading %1 messages of closed %2, "
+			"total loaded in closed chats %3."
+			).arg(count
+			).arg(history->peer->id.value
+			).arg(total));
+		history->clear(History::ClearType::Unload);
+		total -= count;
+	}
+	_closedLoaded.erase(
+		begin(_closedLoaded),
+		begin(_closedLoaded) + unloaded);
+}
+
 void Histories::readInbox(not_null<History*> history) {
 	DEBUG_LOG(("Reading: readInbox called."));
 	if (history->lastServerMessageKnown()) {
@@ -712,6 +862,68 @@ void Histories::deleteMessages(const MessageIdsList &ids, bool revoke) {
 	}
 }
 
+void Histories::readCachedSlice(
+		not_null<History*> history,
+		Fn<void(const QVector<MTPMessage>&)> done) {
+	const auto peerId = history->peer->id;
+	const auto key = CachedSliceKey(peerId);
+	owner().cacheMessages().get(key, [=](QByteArray &&value) {
+		auto parsed = DeserializeSlice(value);
+		if (!parsed) {
+			return;
+		}
+		crl::on_main(&session(), [=, slice = std::move(*parsed)] {
+			if (!find(peerId)) {
+				return;
+			}
+			slice.match([&](const MTPDmessages_messages &data) {
+				// Cached peers may be outdated, use them only as a fallback.
+				for (const auto &user : data.vusers().v) {
+					if (!owner().peerLoaded(PeerFromUser(user))) {
+						owner().processUser(user);
+					}
+				}
+				for (const auto &chat : data.vchats().v) {
+					if (!owner().peerLoaded(PeerFromChat(chat))) {
+						owner().processChat(chat);
+					}
+				}
+				done(data.vmessages().v);
+			}, [](const auto &) {
+			});
+		});
+	});
+}
+
+void Histories::cacheSlice(
+		not_null<History*> history,
+		const MTPmessages_Messages &slice) {
+	const auto trimmed = slice.match([](
+			const MTPDmessages_messagesNotModified &) {
+		return std::optional<MTPmessages_Messages>();
+	}, [](const auto &data) {
+		return std::make_optional(MTP_messages_messages(
+			data.vmessages(),
+			data.vchats(),
+			data.vusers()));
+	});
+	const auto key = CachedSliceKey(history->peer->id);
+	if (!trimmed || trimmed->c_messages_messages().vmessages().v.isEmpty()) {
+		owner().cacheMessages().remove(key);
+		return;
+	}
+	auto serialized = SerializeSlice(*trimmed);
+	if (serialized.size() > Storage::kMaxFileInMemory) {
+		owner().cacheMessages().remove(key);
+		return;
+	}
+	owner().cacheMessages().put(key, std::move(serialized));
+}
+
+void Histories::clearCachedSlice(not_null<const History*> history) {
+	owner().cacheMessages().remove(CachedSliceKey(history->peer->id));
+}
+
 int Histories::sendRequest(
 		not_null<History*> history,
 		RequestType type,
@@ -44,6 +44,24 @@ public:
 	void unloadAll();
 	void clearAll();
 
+	// Closed histories keep their loaded blocks until the total count of
+	// loaded messages in them exceeds a limit, then the oldest closed
+	// histories are unloaded and will be loaded again when opened.
+	void historyOpened(not_null<History*> history);
+	void historyClosed(not_null<History*> history);
+
+	struct LoadedViews {
+		not_null<History*> history;
+		int count = 0;
+		bool closed = false;
+	};
+	// Histories with loaded messages, the most loaded first.
+	[[nodiscard]] std::vector<LoadedViews> loadedViews() const;
+
+	// A closed history receiving a lot of new messages at once (from a
+	// difference after a reconnect) is unloaded instead of creating views.
+	void prepareForNewMessages(const QVector<MTPMessage> &messages);
+
 	void readInbox(not_null<History*> history);
 	void readInboxTill(not_null<HistoryItem*> item);
 	void readInboxTill(not_null<History*> history, MsgId tillId);
@@ -71,6 +89,17 @@ public:
 
 	void deleteMessages(const MessageIdsList &ids, bool revoke);
 
+	// Last loaded bottom slice of each history is kept in the encrypted
+	// messages cache, so that a chat can be shown before the server
+	// answers to the first request. The network slice always wins.
+	void readCachedSlice(
+		not_null<History*> history,
+		Fn<void(const QVector<MTPMessage>&)> done);
+	void cacheSlice(
+		not_null<History*> history,
+		const MTPmessages_Messages &slice);
+	void clearCachedSlice(not_null<const History*> history);
+
 	int sendRequest(
 		not_null<History*> history,
 		RequestType type,
@@ -111,6 +140,7 @@ private:
 	void postponeRequestDialogEntries();
 
 	void sendDialogRequests();
+	void checkClosedLoadedLimit();
 
 	const not_null<Session*> _owner;
 
@@ -130,6 +160,9 @@ private:
 
 	base::flat_set<not_null<History*>> _fakeChatListRequests;
 
+	// Least recently closed first.
+	std::deque<not_null<History*>> _closedLoaded;
+
 };
 
 } // namespace Data
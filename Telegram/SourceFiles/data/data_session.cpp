@@ -214,6 +214,9 @@ Session::Session(not_null<Main::Session*> session)
 , _bigFileCache(Core::App().databases().get(
 	_session->local().cacheBigFilePath(),
 	_session->local().cacheBigFileSettings()))
+, _messagesCache(Core::App().databases().get(
+	_session->local().cacheMessagesPath(),
+	_session->local().cacheMessagesSettings()))
 , _chatsList(
 	session,
 	FilterId(),
@@ -237,6 +240,7 @@ Session::Session(not_null<Main::Session*> session)
 , _stickers(std::make_unique<Stickers>(this)) {
 	_cache->open(_session->local().cacheKey());
 	_bigFileCache->open(_session->local().cacheBigFileKey());
+	_messagesCache->open(_session->local().cacheKey());
 
 	if constexpr (Platform::IsLinux()) {
 		const auto wasVersion = _session->local().oldMapVersion();
@@ -1096,6 +1100,10 @@ Storage::Cache::Database &Session::cacheBigFile() {
 	return *_bigFileCache;
 }
 
+Storage::Cache::Database &Session::cacheMessages() {
+	return *_messagesCache;
+}
+
 void Session::suggestStartExport(TimeId availableAt) {
 	_exportAvailableAt = availableAt;
 	suggestStartExport();
@@ -1542,6 +1550,7 @@ rpl::producer<not_null<const History*>> Session::historyUnloaded() const {
 }
 
 void Session::notifyHistoryCleared(not_null<const History*> history) {
+	_histories->clearCachedSlice(history);
 	_historyCleared.fire_copy(history);
 }
 
@@ -1884,6 +1893,9 @@ void Session::updateEditedMessage(const MTPMessage &data) {
 void Session::processMessages(
 		const QVector<MTPMessage> &data,
 		NewMessageType type) {
+	if (type == NewMessageType::Unread) {
+		_histories->prepareForNewMessages(data);
+	}
 	auto indices = base::flat_map<uint64, int>();
 	for (int i = 0, l = data.size(); i != l; ++i) {
 		const auto &message = data[i];
@@ -4122,6 +4134,8 @@ void Session::clearLocalStorage() {
 	_cache->clear();
 	_bigFileCache->close();
 	_bigFileCache->clear();
+	_messagesCache->close();
+	_messagesCache->clear();
 }
 
 } // namespace Data
@@ -1206,6 +1206,12 @@ StickersSet *Stickers::feedSet(const MTPDstickerSet &data) {
 }
 
 StickersSet *Stickers::feedSetFull(const MTPmessages_StickerSet &data) {
+	const auto result = applySetFull(data);
+	notifyUpdated();
+	return result;
+}
+
+StickersSet *Stickers::applySetFull(const MTPmessages_StickerSet &data) {
 	Expects(data.type() == mtpc_messages_stickerSet);
 	Expects(data.c_messages_stickerSet().vset().type() == mtpc_stickerSet);
 
@@ -1312,8 +1318,6 @@ StickersSet *Stickers::feedSetFull(const MTPmessages_StickerSet &data) {
 		}
 	}
 
-	notifyUpdated();
-
 	return set;
 }
 
@@ -164,6 +164,9 @@ public:
 
 	StickersSet *feedSet(const MTPDstickerSet &data);
 	StickersSet *feedSetFull(const MTPmessages_StickerSet &data);
+
+	// Same as feedSetFull(), but without notifyUpdated().
+	StickersSet *applySetFull(const MTPmessages_StickerSet &data);
 	void newSetReceived(const MTPmessages_StickerSet &data);
 
 	QString getSetTitle(const MTPDstickerSet &s);
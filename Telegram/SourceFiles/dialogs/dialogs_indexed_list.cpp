@@ -12,6 +12,48 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "history/history.h"
 
 namespace Dialogs {
+namespace {
+
+[[nodiscard]] bool NameWordsHavePrefix(
+		const base::flat_set<QString> &nameWords,
+		const QString &word) {
+	// Name words are sorted, so all words starting with the given one
+	// follow it directly, the first of them (if any) is the lower bound.
+	const auto i = nameWords.lower_bound(word);
+	return (i != nameWords.end()) && i->startsWith(word);
+}
+
+[[nodiscard]] bool NameWordsHaveAll(
+		const base::flat_set<QString> &nameWords,
+		const QStringList &words) {
+	for (const auto &word : words) {
+		if (!NameWordsHavePrefix(nameWords, word)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// If each of the previous words is a prefix of some of the new words,
+// the new result is a subset of the previous one (keeping the order).
+[[nodiscard]] bool IsNarrowingOf(
+		const QStringList &words,
+		const QStringList &previous) {
+	if (previous.isEmpty()) {
+		return false;
+	}
+	for (const auto &was : previous) {
+		const auto narrowed = ranges::any_of(words, [&](const QString &word) {
+			return word.startsWith(was);
+		});
+		if (!narrowed) {
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace
 
 IndexedList::IndexedList(SortMode sortMode, FilterId filterId)
 : _sortMode(sortMode)
@@ -21,6 +63,7 @@ IndexedList::IndexedList(SortMode sortMode, FilterId filterId)
 }
 
 RowsByLetter IndexedList::addToEnd(Key key) {
+	clearFilteredCache();
 	if (const auto row = _list.getRow(key)) {
 		return { row };
 	}
@@ -37,6 +80,7 @@ RowsByLetter IndexedList::addToEnd(Key key) {
 }
 
 Row *IndexedList::addByName(Key key) {
+	clearFilteredCache();
 	if (const auto row = _list.getRow(key)) {
 		return row;
 	}
@@ -53,6 +97,7 @@ Row *IndexedList::addByName(Key key) {
 }
 
 void IndexedList::adjustByDate(const RowsByLetter &links) {
+	clearFilteredCache();
 	_list.adjustByDate(links.main);
 	for (const auto &[ch, row] : links.letters) {
 		if (auto it = _index.find(ch); it != _index.cend()) {
@@ -62,6 +107,7 @@ void IndexedList::adjustByDate(const RowsByLetter &links) {
 }
 
 void IndexedList::moveToTop(Key key) {
+	clearFilteredCache();
 	if (_list.moveToTop(key)) {
 		for (const auto ch : key.entry()->chatListFirstLetters()) {
 			if (auto it = _index.find(ch); it != _index.cend()) {
@@ -115,6 +161,7 @@ void IndexedList::adjustByName(
 		Key key,
 		const base::flat_set<QChar> &oldLetters) {
 	Expects(_sortMode == SortMode::Name);
+	clearFilteredCache();
 
 	const auto mainRow = _list.adjustByName(key);
 	if (!mainRow) return;
@@ -152,6 +199,7 @@ void IndexedList::adjustNames(
 		FilterId filterId,
 		not_null<History*> history,
 		const base::flat_set<QChar> &oldLetters) {
+	clearFilteredCache();
 	const auto key = Dialogs::Key(history);
 	auto mainRow = _list.getRow(key);
 	if (!mainRow) return;
@@ -187,6 +235,7 @@ void IndexedList::adjustNames(
 }
 
 void IndexedList::del(Key key, Row *replacedBy) {
+	clearFilteredCache();
 	if (_list.del(key, replacedBy)) {
 		for (const auto ch : key.entry()->chatListFirstLetters()) {
 			if (auto it = _index.find(ch); it != _index.cend()) {
@@ -197,11 +246,31 @@ void IndexedList::del(Key key, Row *replacedBy) {
 }
 
 void IndexedList::clear() {
+	clearFilteredCache();
 	_index.clear();
 }
 
+void IndexedList::clearFilteredCache() {
+	_filteredWords.clear();
+	_filteredRows.clear();
+}
+
 std::vector<not_null<Row*>> IndexedList::filtered(
 		const QStringList &words) const {
+	if (!_filteredWords.isEmpty() && words == _filteredWords) {
+		return _filteredRows;
+	} else if (IsNarrowingOf(words, _filteredWords)) {
+		// Typing the query further only removes rows from the result.
+		_filteredRows.erase(
+			ranges::remove_if(_filteredRows, [&](not_null<Row*> row) {
+				return !NameWordsHaveAll(
+					row->entry()->chatListNameWords(),
+					words);
+			}),
+			end(_filteredRows));
+		_filteredWords = words;
+		return _filteredRows;
+	}
 	const auto minimal = [&]() -> const Dialogs::List* {
 		if (empty()) {
 			return nullptr;
@@ -221,32 +290,16 @@ std::vector<not_null<Row*>> IndexedList::filtered(
 		return result;
 	}();
 	auto result = std::vector<not_null<Row*>>();
-	if (!minimal || minimal->empty()) {
-		return result;
-	}
-	result.reserve(minimal->size());
-	for (const auto row : *minimal) {
-		const auto &nameWords = row->entry()->chatListNameWords();
-		const auto found = [&](const QString &word) {
-			for (const auto &name : nameWords) {
-				if (name.startsWith(word)) {
-					return true;
-				}
-			}
-			return false;
-		};
-		const auto allFound = [&] {
-			for (const auto &word : words) {
-				if (!found(word)) {
-					return false;
-				}
+	if (minimal && !minimal->empty()) {
+		result.reserve(minimal->size());
+		for (const auto row : *minimal) {
+			if (NameWordsHaveAll(row->entry()->chatListNameWords(), words)) {
+				result.push_back(row);
 			}
-			return true;
-		}();
-		if (allFound) {
-			result.push_back(row);
 		}
 	}
+	_filteredWords = words;
+	_filteredRows = result;
 	return result;
 }
 
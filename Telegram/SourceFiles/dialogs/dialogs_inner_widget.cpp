@@ -2102,6 +2102,22 @@ bool InnerWidget::searchReceived(
 	return lastDateFound != 0;
 }
 
+void InnerWidget::searchInLoadedReceived(
+		std::vector<not_null<HistoryItem*>> &&items) {
+	if (_state != WidgetState::Filtered || !_searchInChat) {
+		return;
+	}
+	clearSearchResults(false);
+	for (const auto item : items) {
+		_searchResults.push_back(
+			std::make_unique<FakeRow>(_searchInChat, item));
+	}
+	_searchedCount = int(_searchResults.size());
+	_waitingForSearch = _searchResults.empty();
+
+	refresh();
+}
+
 void InnerWidget::peerSearchReceived(
 		const QString &query,
 		const QVector<MTPPeer> &my,
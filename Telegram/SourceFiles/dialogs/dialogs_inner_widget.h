@@ -75,6 +75,9 @@ public:
 		HistoryItem *inject,
 		SearchRequestType type,
 		int fullCount);
+
+	// Matches from the loaded messages are shown until the server answers.
+	void searchInLoadedReceived(std::vector<not_null<HistoryItem*>> &&items);
 	void peerSearchReceived(
 		const QString &query,
 		const QVector<MTPPeer> &my,
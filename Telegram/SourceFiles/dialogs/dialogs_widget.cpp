@@ -12,6 +12,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "dialogs/dialogs_key.h"
 #include "dialogs/dialogs_entry.h"
 #include "history/history.h"
+#include "history/history_item.h"
+#include "history/view/history_view_element.h"
 #include "history/view/history_view_top_bar_widget.h"
 #include "ui/widgets/buttons.h"
 #include "ui/widgets/input_fields.h"
@@ -60,6 +62,41 @@ QString SwitchToChooseFromQuery() {
 	return qsl("from:");
 }
 
+// Newest first, like the messages.search results.
+void SearchInLoaded(
+		not_null<History*> history,
+		const QStringList &words,
+		PeerData *from,
+		int limit,
+		std::vector<not_null<HistoryItem*>> &result) {
+	const auto matches = [&](not_null<HistoryItem*> item) {
+		if (item->isService()
+			|| !IsServerMsgId(item->id)
+			|| (from && item->from() != from)) {
+			return false;
+		}
+		const auto text = item->originalText().text;
+		if (text.isEmpty()) {
+			return false;
+		}
+		const auto itemWords = TextUtilities::PrepareSearchWords(text);
+		return ranges::all_of(words, [&](const QString &word) {
+			return ranges::any_of(itemWords, [&](const QString &itemWord) {
+				return itemWord.startsWith(word);
+			});
+		});
+	};
+	for (const auto &block : ranges::views::reverse(history->blocks)) {
+		for (const auto &view : ranges::views::reverse(block->messages)) {
+			if (int(result.size()) >= limit) {
+				return;
+			} else if (const auto item = view->data(); matches(item)) {
+				result.push_back(item);
+			}
+		}
+	}
+}
+
 } // namespace
 
 class Widget::BottomButton : public Ui::RippleButton {
@@ -828,6 +865,8 @@ bool Widget::onSearchMessages(bool searchCache) {
 				i->second,
 				0);
 			result = true;
+		} else {
+			searchInLoaded(q);
 		}
 	} else if (_searchQuery != q || _searchQueryFrom != _searchFromAuthor) {
 		_searchQuery = q;
@@ -942,6 +981,25 @@ bool Widget::searchForPeersRequired(const QString &query) const {
 	return (query[0] != '#');
 }
 
+void Widget::searchInLoaded(const QString &query) {
+	const auto history = _searchInChat.history();
+	const auto words = TextUtilities::PrepareSearchWords(query);
+	if (!history || words.isEmpty()) {
+		return;
+	}
+	auto items = std::vector<not_null<HistoryItem*>>();
+	SearchInLoaded(history, words, _searchFromAuthor, SearchPerPage, items);
+	if (const auto migrated = history->migrateFrom()) {
+		SearchInLoaded(
+			migrated,
+			words,
+			_searchFromAuthor,
+			SearchPerPage,
+			items);
+	}
+	_inner->searchInLoadedReceived(std::move(items));
+}
+
 void Widget::onNeedSearchMessages() {
 	if (!onSearchMessages(true)) {
 		_searchTimer.start(AutoSearchTimeout);
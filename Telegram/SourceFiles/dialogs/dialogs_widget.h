@@ -140,6 +140,7 @@ private:
 	void peerSearchReceived(
 		const MTPcontacts_Found &result,
 		mtpRequestId requestId);
+	void searchInLoaded(const QString &query);
 	void escape();
 	void cancelSearchRequest();
 
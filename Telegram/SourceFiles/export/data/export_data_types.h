@@ -24,6 +24,9 @@ namespace Data {
 
 using Utf8String = QByteArray;
 
+// Messages of a legacy group migrated to a supergroup have shifted ids.
+inline constexpr auto kMigratedMessagesIdShift = -1'000'000'000;
+
 int PeerColorIndex(BareId bareId);
 BareId PeerToBareId(PeerId peerId);
 int PeerColorIndex(PeerId peerId);
@@ -643,6 +646,12 @@ struct DialogInfo {
 	std::vector<int> messagesCountPerSplit;
 };
 
+// Largest message ids of a chat found in previous exports.
+struct ExportedMessageIds {
+	int32 lastId = 0;
+	int32 lastMigratedId = 0;
+};
+
 struct DialogsInfo {
 	DialogInfo *item(int index);
 	const DialogInfo *item(int index) const;
@@ -11,6 +11,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "export/data/export_data_types.h"
 #include "export/output/export_output_result.h"
 #include "export/output/export_output_file.h"
+#include "export/output/export_output_journal.h"
 #include "mtproto/mtproto_response.h"
 #include "base/value_ordering.h"
 #include "base/bytes.h"
@@ -23,8 +24,7 @@ namespace {
 
 constexpr auto kUserpicsSliceLimit = 100;
 constexpr auto kFileChunkSize = 128 * 1024;
-constexpr auto kFileRequestsCount = 2;
-constexpr auto kFileNextRequestDelay = crl::time(20);
+constexpr auto kFileRequestsCount = 4;
 constexpr auto kChatsSliceLimit = 100;
 constexpr auto kMessagesSliceLimit = 100;
 constexpr auto kTopPeerSliceLimit = 100;
@@ -101,6 +101,7 @@ public:
 	LoadedFileCache(int limit);
 
 	void save(const Location &location, const QString &relativePath);
+	void save(const LocationKey &key, const QString &relativePath);
 	std::optional<QString> find(const Location &location) const;
 
 private:
@@ -150,6 +151,12 @@ struct ApiWrap::OtherDataProcess {
 	FnMut<void(Data::File&&)> done;
 };
 
+struct ApiWrap::FilePartRequest {
+	int offset = 0;
+	QByteArray bytes;
+	mtpRequestId requestId = 0;
+};
+
 struct ApiWrap::FileProcess {
 	FileProcess(const QString &path, Output::Stats *stats);
 
@@ -165,11 +172,7 @@ struct ApiWrap::FileProcess {
 	int offset = 0;
 	int size = 0;
 
-	struct Request {
-		int offset = 0;
-		QByteArray bytes;
-	};
-	std::deque<Request> requests;
+	std::deque<FilePartRequest> requests;
 	mtpRequestId requestId = 0;
 };
 
@@ -212,6 +215,7 @@ struct ApiWrap::ChatProcess {
 
 	int localSplitIndex = 0;
 	int32 largestIdPlusOne = 1;
+	Data::ExportedMessageIds exported;
 
 	Data::ParseMediaContext context;
 	std::optional<Data::MessagesSlice> slice;
@@ -306,7 +310,12 @@ void ApiWrap::LoadedFileCache::save(
 	if (!location) {
 		return;
 	}
-	const auto key = ComputeLocationKey(location);
+	save(ComputeLocationKey(location), relativePath);
+}
+
+void ApiWrap::LoadedFileCache::save(
+		const LocationKey &key,
+		const QString &relativePath) {
 	_map[key] = relativePath;
 	_list.push_back(key);
 	if (_list.size() > _limit) {
@@ -372,7 +381,9 @@ auto ApiWrap::fileRequest(const Data::FileLocation &location, int offset) {
 			MTP_int(offset),
 			MTP_int(kFileChunkSize))
 	)).fail([=](const MTP::Error &result) {
-		_fileProcess->requestId = 0;
+		if (const auto request = filePartRequest(offset)) {
+			request->requestId = 0;
+		}
 		if (result.type() == qstr("TAKEOUT_FILE_EMPTY")
 			&& _otherDataProcess != nullptr) {
 			filePartDone(
@@ -416,6 +427,16 @@ void ApiWrap::startExport(
 
 	_settings = std::make_unique<Settings>(settings);
 	_stats = stats;
+	_journal = std::make_unique<Output::Journal>(_settings->path, settings);
+	if (!_journal->valid()) {
+		ioError(Output::Result(Output::Result::Type::Error, _journal->path()));
+		return;
+	}
+	for (const auto &entry : _journal->takeFinishedFiles()) {
+		_fileCache->save(
+			LocationKey{ entry.keyType, entry.keyId },
+			entry.relativePath);
+	}
 	_startProcess = std::make_unique<StartProcess>();
 	_startProcess->done = std::move(done);
 
@@ -956,10 +977,35 @@ void ApiWrap::requestMessages(
 	_chatProcess->fileProgress = std::move(progress);
 	_chatProcess->handleSlice = std::move(slice);
 	_chatProcess->done = std::move(done);
+	const auto i = _exportedMessageIds.find(info.peerId);
+	if (i != end(_exportedMessageIds)) {
+		_chatProcess->exported = i->second;
+	}
+	_chatProcess->largestIdPlusOne = firstMessageId(0);
 
 	requestMessagesCount(0);
 }
 
+void ApiWrap::setExportedMessageIds(
+		std::map<PeerId, Data::ExportedMessageIds> &&ids) {
+	_exportedMessageIds = std::move(ids);
+}
+
+int32 ApiWrap::firstMessageId(int localSplitIndex) const {
+	Expects(_chatProcess != nullptr);
+	Expects(localSplitIndex < _chatProcess->info.splits.size());
+
+	// Zero means that everything in this split was exported before.
+	const auto &exported = _chatProcess->exported;
+	const auto splitIndex = _chatProcess->info.splits[localSplitIndex];
+	if (splitIndex >= 0) {
+		return exported.lastId + 1;
+	} else if (exported.lastId > 0) {
+		return 0;
+	}
+	return exported.lastMigratedId + 1;
+}
+
 void ApiWrap::requestMessagesCount(int localSplitIndex) {
 	Expects(_chatProcess != nullptr);
 	Expects(localSplitIndex < _chatProcess->info.splits.size());
@@ -1038,6 +1084,9 @@ void ApiWrap::messagesCountLoaded(int localSplitIndex, int count) {
 void ApiWrap::finishExport(FnMut<void()> done) {
 	const auto guard = gsl::finally([&] { _takeoutId = std::nullopt; });
 
+	if (_journal) {
+		base::take(_journal)->remove();
+	}
 	mainRequest(MTPaccount_FinishTakeoutSession(
 		MTP_flags(MTPaccount_FinishTakeoutSession::Flag::f_success)
 	)).done(std::move(done)).send();
@@ -1049,8 +1098,10 @@ void ApiWrap::skipFile(uint64 randomId) {
 	}
 	LOG(("Export Info: File skipped."));
 	Assert(!_fileProcess->requests.empty());
-	Assert(_fileProcess->requestId != 0);
-	_mtp.request(base::take(_fileProcess->requestId)).cancel();
+	if (const auto requestId = base::take(_fileProcess->requestId)) {
+		_mtp.request(requestId).cancel();
+	}
+	cancelFileParts();
 	base::take(_fileProcess)->done(QString());
 }
 
@@ -1371,7 +1422,7 @@ void ApiWrap::requestMessagesSlice() {
 
 	const auto count = _chatProcess->info.messagesCountPerSplit[
 		_chatProcess->localSplitIndex];
-	if (!count) {
+	if (!count || !_chatProcess->largestIdPlusOne) {
 		loadMessagesFiles({});
 		return;
 	}
@@ -1567,7 +1618,8 @@ void ApiWrap::finishMessagesSlice() {
 		&& (++_chatProcess->localSplitIndex
 			< _chatProcess->info.splits.size())) {
 		_chatProcess->lastSlice = false;
-		_chatProcess->largestIdPlusOne = 1;
+		_chatProcess->largestIdPlusOne = firstMessageId(
+			_chatProcess->localSplitIndex);
 	}
 	if (!_chatProcess->lastSlice) {
 		requestMessagesSlice();
@@ -1701,7 +1753,7 @@ bool ApiWrap::writePreloadedFile(
 		const auto process = prepareFileProcess(file, origin);
 		if (const auto result = process->file.writeBlock(file.content)) {
 			file.relativePath = process->relativePath;
-			_fileCache->save(file.location, file.relativePath);
+			fileSaved(file.location, file.relativePath, process->file.size());
 		} else {
 			ioError(result);
 		}
@@ -1735,7 +1787,7 @@ void ApiWrap::loadFile(
 
 	loadFilePart();
 
-	Ensures(_fileProcess->requestId != 0);
+	Ensures(!_fileProcess->requests.empty());
 }
 
 auto ApiWrap::prepareFileProcess(
@@ -1759,43 +1811,75 @@ auto ApiWrap::prepareFileProcess(
 }
 
 void ApiWrap::loadFilePart() {
-	if (!_fileProcess
-		|| _fileProcess->requestId
-		|| _fileProcess->requests.size() >= kFileRequestsCount
-		|| (_fileProcess->size > 0
-			&& _fileProcess->offset >= _fileProcess->size)) {
+	if (!_fileProcess || _fileProcess->requestId) {
 		return;
 	}
 
-	const auto offset = _fileProcess->offset;
-	_fileProcess->requests.push_back({ offset });
-	_fileProcess->requestId = fileRequest(
+	// We don't know where the file ends without its size,
+	// so in that case only one part is requested at a time.
+	const auto size = _fileProcess->size;
+	const auto window = (size > 0) ? kFileRequestsCount : 1;
+	auto &requests = _fileProcess->requests;
+	while (int(requests.size()) < window
+		&& (size <= 0 || _fileProcess->offset < size)) {
+		requests.push_back({ _fileProcess->offset });
+		sendFilePart(requests.back());
+		_fileProcess->offset += kFileChunkSize;
+	}
+}
+
+void ApiWrap::sendFilePart(FilePartRequest &request) {
+	Expects(_fileProcess != nullptr);
+
+	const auto offset = request.offset;
+	request.requestId = fileRequest(
 		_fileProcess->location,
-		_fileProcess->offset
+		offset
 	).done([=](const MTPupload_File &result) {
-		_fileProcess->requestId = 0;
 		filePartDone(offset, result);
 	}).send();
-	_fileProcess->offset += kFileChunkSize;
-
-	if (_fileProcess->size > 0
-		&& _fileProcess->requests.size() < kFileRequestsCount) {
-		// Only one request at a time supported right now.
-		//const auto runner = _runner;
-		//crl::on_main([=] {
-		//	QTimer::singleShot(kFileNextRequestDelay, [=] {
-		//		runner([=] {
-		//			loadFilePart();
-		//		});
-		//	});
-		//});
+}
+
+void ApiWrap::resendFileParts() {
+	Expects(_fileProcess != nullptr);
+	Expects(_fileProcess->requestId == 0);
+
+	for (auto &request : _fileProcess->requests) {
+		if (!request.requestId && request.bytes.isEmpty()) {
+			sendFilePart(request);
+		}
 	}
 }
 
+void ApiWrap::cancelFileParts() {
+	Expects(_fileProcess != nullptr);
+
+	for (auto &request : _fileProcess->requests) {
+		if (const auto requestId = base::take(request.requestId)) {
+			_mtp.request(requestId).cancel();
+		}
+	}
+}
+
+auto ApiWrap::filePartRequest(int offset) -> FilePartRequest* {
+	Expects(_fileProcess != nullptr);
+
+	auto &requests = _fileProcess->requests;
+	const auto i = ranges::find(
+		requests,
+		offset,
+		[](const FilePartRequest &request) { return request.offset; });
+	return (i != end(requests)) ? &*i : nullptr;
+}
+
 void ApiWrap::filePartDone(int offset, const MTPupload_File &result) {
 	Expects(_fileProcess != nullptr);
 	Expects(!_fileProcess->requests.empty());
 
+	const auto request = filePartRequest(offset);
+	Assert(request != nullptr);
+	request->requestId = 0;
+
 	if (result.type() == mtpc_upload_fileCdnRedirect) {
 		error("Cdn redirect is not supported.");
 		return;
@@ -1812,16 +1896,9 @@ void ApiWrap::filePartDone(int offset, const MTPupload_File &result) {
 			return;
 		}
 	} else {
-		using Request = FileProcess::Request;
-		auto &requests = _fileProcess->requests;
-		const auto i = ranges::find(
-			requests,
-			offset,
-			[](const Request &request) { return request.offset; });
-		Assert(i != end(requests));
-
-		i->bytes = data.vbytes().v;
+		request->bytes = data.vbytes().v;
 
+		auto &requests = _fileProcess->requests;
 		auto &file = _fileProcess->file;
 		while (!requests.empty() && !requests.front().bytes.isEmpty()) {
 			const auto &bytes = requests.front().bytes;
@@ -1848,14 +1925,33 @@ void ApiWrap::filePartDone(int offset, const MTPupload_File &result) {
 
 	auto process = base::take(_fileProcess);
 	const auto relativePath = process->relativePath;
-	_fileCache->save(process->location, relativePath);
+	fileSaved(process->location, relativePath, process->file.size());
 	process->done(process->relativePath);
 }
 
+void ApiWrap::fileSaved(
+		const Data::FileLocation &location,
+		const QString &relativePath,
+		int64 size) {
+	_fileCache->save(location, relativePath);
+	if (location && _journal) {
+		const auto key = ComputeLocationKey(location);
+		_journal->fileDone({
+			.keyType = key.type,
+			.keyId = key.id,
+			.relativePath = relativePath,
+			.size = size,
+		});
+	}
+}
+
 void ApiWrap::filePartRefreshReference(int offset) {
 	Expects(_fileProcess != nullptr);
-	Expects(_fileProcess->requestId == 0);
 
+	if (_fileProcess->requestId) {
+		// The failed part will be resent when the reference is refreshed.
+		return;
+	}
 	const auto &origin = _fileProcess->origin;
 	if (!origin.messageId) {
 		error("FILE_REFERENCE error for non-message file.");
@@ -1931,13 +2027,7 @@ void ApiWrap::filePartExtractReference(
 					_fileProcess->location,
 					message.thumb().file.location);
 				if (refresh1 || refresh2) {
-					_fileProcess->requestId = fileRequest(
-						_fileProcess->location,
-						offset
-					).done([=](const MTPupload_File &result) {
-						_fileProcess->requestId = 0;
-						filePartDone(offset, result);
-					}).send();
+					resendFileParts();
 					return;
 				}
 			}
@@ -1952,6 +2042,7 @@ void ApiWrap::filePartUnavailable() {
 
 	LOG(("Export Error: File unavailable."));
 
+	cancelFileParts();
 	base::take(_fileProcess)->done(QString());
 }
 
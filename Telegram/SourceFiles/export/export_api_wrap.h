@@ -30,6 +30,7 @@ struct FileOrigin;
 namespace Output {
 struct Result;
 class Stats;
+class Journal;
 } // namespace Output
 
 struct Settings;
@@ -77,6 +78,8 @@ public:
 
 	void requestSessions(FnMut<void(Data::SessionsList&&)> done);
 
+	void setExportedMessageIds(
+		std::map<PeerId, Data::ExportedMessageIds> &&ids);
 	void requestMessages(
 		const Data::DialogInfo &info,
 		FnMut<bool(const Data::DialogInfo &)> start,
@@ -97,6 +100,7 @@ private:
 	struct UserpicsProcess;
 	struct OtherDataProcess;
 	struct FileProcess;
+	struct FilePartRequest;
 	struct FileProgress;
 	struct ChatsProcess;
 	struct LeftChannelsProcess;
@@ -150,6 +154,7 @@ private:
 	void checkFirstMessageDate(int localSplitIndex, int count);
 	void messagesCountLoaded(int localSplitIndex, int count);
 	void requestMessagesSlice();
+	[[nodiscard]] int32 firstMessageId(int localSplitIndex) const;
 	void requestChatMessages(
 		int splitIndex,
 		int offsetId,
@@ -187,6 +192,14 @@ private:
 		FnMut<void(QString)> done);
 	void loadFilePart();
 	void filePartDone(int offset, const MTPupload_File &result);
+	void fileSaved(
+		const Data::FileLocation &location,
+		const QString &relativePath,
+		int64 size);
+	void sendFilePart(FilePartRequest &request);
+	void resendFileParts();
+	void cancelFileParts();
+	[[nodiscard]] FilePartRequest *filePartRequest(int offset);
 	void filePartUnavailable();
 	void filePartRefreshReference(int offset);
 	void filePartExtractReference(
@@ -220,6 +233,7 @@ private:
 
 	std::unique_ptr<StartProcess> _startProcess;
 	std::unique_ptr<LoadedFileCache> _fileCache;
+	std::unique_ptr<Output::Journal> _journal;
 	std::unique_ptr<ContactsProcess> _contactsProcess;
 	std::unique_ptr<UserpicsProcess> _userpicsProcess;
 	std::unique_ptr<OtherDataProcess> _otherDataProcess;
@@ -228,6 +242,7 @@ private:
 	std::unique_ptr<DialogsProcess> _dialogsProcess;
 	std::unique_ptr<ChatProcess> _chatProcess;
 	QVector<MTPMessageRange> _splits;
+	std::map<PeerId, Data::ExportedMessageIds> _exportedMessageIds;
 
 	rpl::event_stream<MTP::Error> _errors;
 	rpl::event_stream<Output::Result> _ioErrors;
@@ -83,6 +83,9 @@ struct Settings {
 
 	TimeId availableAt = 0;
 
+	// Export only messages newer than the ones in previous JSON exports.
+	bool incremental = false;
+
 	bool onlySinglePeer() const {
 		return singlePeer.type() != mtpc_inputPeerEmpty;
 	}
@@ -9,6 +9,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include "export/output/export_output_html.h"
 #include "export/output/export_output_json.h"
+#include "export/output/export_output_journal.h"
 #include "export/output/export_output_stats.h"
 #include "export/output/export_output_result.h"
 
@@ -30,11 +31,21 @@ QString NormalizePath(const Settings &settings) {
 	if (list.isEmpty() && !settings.forceSubPath) {
 		return result;
 	}
+	const auto prefix = QString(settings.onlySinglePeer()
+		? "ChatExport_"
+		: "DataExport_");
+	if (!settings.forceSubPath && Journal::Resumable(result, settings)) {
+		return result;
+	}
+	for (const auto &entry : list) {
+		if (entry.isDir()
+			&& entry.fileName().startsWith(prefix)
+			&& Journal::Resumable(entry.absoluteFilePath() + '/', settings)) {
+			return entry.absoluteFilePath() + '/';
+		}
+	}
 	const auto date = QDate::currentDate();
-	const auto base = QString(settings.onlySinglePeer()
-		? "ChatExport_%1"
-		: "DataExport_%1"
-	).arg(date.toString(Qt::ISODate));
+	const auto base = prefix + date.toString(Qt::ISODate);
 	const auto add = [&](int i) {
 		return base + (i ? " (" + QString::number(i) + ')' : QString());
 	};
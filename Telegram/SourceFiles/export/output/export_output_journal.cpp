@@ -0,0 +1,191 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "export/output/export_output_journal.h"
+
+#include "export/export_settings.h"
+
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+
+namespace Export {
+namespace Output {
+namespace {
+
+constexpr auto kJournalName = ".export_journal";
+constexpr auto kJournalMagic = quint32(0x4A455444); // "TDEJ"
+constexpr auto kJournalVersion = qint32(1);
+constexpr auto kJournalFileEntry = qint32(1);
+
+[[nodiscard]] QString JournalPath(const QString &folder) {
+	return folder + kJournalName;
+}
+
+[[nodiscard]] QByteArray SettingsDescriptor(const Settings &settings) {
+	auto peer = mtpBuffer();
+	settings.singlePeer.write(peer);
+
+	auto result = QByteArray();
+	{
+		auto stream = QDataStream(&result, QIODevice::WriteOnly);
+		stream.setVersion(QDataStream::Qt_5_1);
+		stream
+			<< quint32(settings.format)
+			<< quint32(settings.types)
+			<< quint32(settings.fullChats)
+			<< quint32(settings.media.types)
+			<< qint32(settings.media.sizeLimit)
+			<< qint32(settings.singlePeerFrom)
+			<< qint32(settings.singlePeerTill)
+			<< qint32(settings.incremental ? 1 : 0)
+			<< QByteArray(
+				reinterpret_cast<const char*>(peer.data()),
+				peer.size() * sizeof(mtpPrime));
+	}
+	return result;
+}
+
+[[nodiscard]] std::optional<QByteArray> ReadDescriptor(
+		QDataStream &stream) {
+	auto magic = quint32();
+	auto version = qint32();
+	auto descriptor = QByteArray();
+	stream >> magic >> version >> descriptor;
+	if (stream.status() != QDataStream::Ok
+		|| magic != kJournalMagic
+		|| version != kJournalVersion) {
+		return std::nullopt;
+	}
+	return descriptor;
+}
+
+} // namespace
+
+Journal::Journal(const QString &folder, const Settings &settings)
+: _folder(folder)
+, _descriptor(SettingsDescriptor(settings)) {
+	// The writer creates the output folder only after the export started.
+	QDir().mkpath(_folder);
+	if (!readExisting()) {
+		startNew();
+	}
+}
+
+bool Journal::Resumable(const QString &folder, const Settings &settings) {
+	auto file = QFile(JournalPath(folder));
+	if (!file.open(QIODevice::ReadOnly)) {
+		return false;
+	}
+	auto stream = QDataStream(&file);
+	stream.setVersion(QDataStream::Qt_5_1);
+	const auto descriptor = ReadDescriptor(stream);
+	return descriptor && (*descriptor == SettingsDescriptor(settings));
+}
+
+bool Journal::Exists(const QString &folder) {
+	return QFile::exists(JournalPath(folder));
+}
+
+bool Journal::valid() const {
+	return _file.has_value();
+}
+
+QString Journal::path() const {
+	return JournalPath(_folder);
+}
+
+std::vector<Journal::FileEntry> Journal::takeFinishedFiles() {
+	return base::take(_finishedFiles);
+}
+
+bool Journal::readExisting() {
+	_file.emplace(JournalPath(_folder));
+	if (!_file->open(QIODevice::ReadWrite)) {
+		return false;
+	}
+	auto stream = QDataStream(&*_file);
+	stream.setVersion(QDataStream::Qt_5_1);
+	const auto descriptor = ReadDescriptor(stream);
+	if (!descriptor || *descriptor != _descriptor) {
+		return false;
+	}
+	auto valid = _file->pos();
+	while (!stream.atEnd()) {
+		auto type = qint32();
+		auto entry = FileEntry();
+		auto size = qint64();
+		stream >> type;
+		if (type != kJournalFileEntry) {
+			break;
+		}
+		stream
+			>> entry.keyType
+			>> entry.keyId
+			>> entry.relativePath
+			>> size;
+		if (stream.status() != QDataStream::Ok) {
+			break;
+		}
+		valid = _file->pos();
+		entry.size = size;
+		const auto info = QFileInfo(_folder + entry.relativePath);
+		if (info.exists() && info.size() == entry.size) {
+			_finishedFiles.push_back(std::move(entry));
+		}
+	}
+
+	// Drop a partially written last entry, if there is one.
+	if (!_file->resize(valid) || !_file->seek(valid)) {
+		_finishedFiles.clear();
+		return false;
+	}
+	return true;
+}
+
+void Journal::startNew() {
+	_finishedFiles.clear();
+	_file.emplace(JournalPath(_folder));
+	if (!_file->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		LOG(("Export Error: Could not create journal in %1.").arg(_folder));
+		_file.reset();
+		return;
+	}
+	auto stream = QDataStream(&*_file);
+	stream.setVersion(QDataStream::Qt_5_1);
+	stream << kJournalMagic << kJournalVersion << _descriptor;
+	if (stream.status() != QDataStream::Ok || !_file->flush()) {
+		LOG(("Export Error: Could not write journal in %1.").arg(_folder));
+		_file.reset();
+	}
+}
+
+void Journal::fileDone(const FileEntry &entry) {
+	if (!_file) {
+		return;
+	}
+	auto stream = QDataStream(&*_file);
+	stream.setVersion(QDataStream::Qt_5_1);
+	stream
+		<< kJournalFileEntry
+		<< entry.keyType
+		<< entry.keyId
+		<< entry.relativePath
+		<< qint64(entry.size);
+	if (stream.status() != QDataStream::Ok || !_file->flush()) {
+		LOG(("Export Error: Could not write journal in %1.").arg(_folder));
+		_file.reset();
+	}
+}
+
+void Journal::remove() {
+	_file.reset();
+	QFile::remove(JournalPath(_folder));
+}
+
+} // namespace Output
+} // namespace Export
@@ -0,0 +1,61 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include <QtCore/QFile>
+#include <QtCore/QString>
+#include <QtCore/QByteArray>
+
+namespace Export {
+
+struct Settings;
+
+namespace Output {
+
+// Checkpoint journal kept in the output folder of an unfinished export.
+// It records the settings of the export and every fully written media
+// file, so that an interrupted export started again with the same
+// settings continues in the same folder without downloading them again.
+class Journal final {
+public:
+	struct FileEntry {
+		uint64 keyType = 0;
+		uint64 keyId = 0;
+		QString relativePath;
+		int64 size = 0;
+	};
+
+	Journal(const QString &folder, const Settings &settings);
+
+	[[nodiscard]] static bool Resumable(
+		const QString &folder,
+		const Settings &settings);
+	[[nodiscard]] static bool Exists(const QString &folder);
+
+	[[nodiscard]] bool valid() const;
+	[[nodiscard]] QString path() const;
+
+	// Entries of the previous run which files are still on disk.
+	[[nodiscard]] std::vector<FileEntry> takeFinishedFiles();
+
+	void fileDone(const FileEntry &entry);
+	void remove();
+
+private:
+	[[nodiscard]] bool readExisting();
+	void startNew();
+
+	const QString _folder;
+	const QByteArray _descriptor;
+	std::optional<QFile> _file;
+	std::vector<FileEntry> _finishedFiles;
+
+};
+
+} // namespace Output
+} // namespace Export
@@ -8,10 +8,16 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "export/output/export_output_json.h"
 
 #include "export/output/export_output_result.h"
+#include "export/output/export_output_journal.h"
 #include "export/data/export_data_types.h"
 #include "core/utils.h"
 
+#include <crl/crl_async.h>
+#include <crl/crl_semaphore.h>
+#include <QtCore/QThread>
 #include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
 #include <QtCore/QJsonDocument>
 #include <QtCore/QJsonObject>
 #include <QtCore/QJsonArray>
@@ -23,6 +29,9 @@ namespace {
 
 using Context = details::JsonContext;
 
+constexpr auto kMessagesInSerializeTask = 16;
+constexpr auto kMaxSerializeTasks = 8;
+
 QByteArray SerializeString(const QByteArray &value) {
 	const auto size = value.size();
 	const auto begin = value.data();
@@ -665,6 +674,182 @@ QByteArray SerializeMessage(
 	return serialized();
 }
 
+struct ScanFrame {
+	bool object = false;
+	bool messages = false;
+	bool message = false;
+	bool hasMessages = false;
+	QByteArray key;
+	QByteArray type;
+	std::optional<int64> id;
+	Data::ExportedMessageIds ids;
+};
+
+[[nodiscard]] PeerId ScannedChatPeerId(const QByteArray &type, int64 id) {
+	if (id <= 0) {
+		return PeerId(0);
+	} else if (type == "personal_chat"
+		|| type == "bot_chat"
+		|| type == "saved_messages"
+		|| type == "replies") {
+		return peerFromUser(UserId(BareId(id)));
+	} else if (type == "private_group") {
+		return peerFromChat(ChatId(BareId(id)));
+	} else if (type == "private_supergroup"
+		|| type == "public_supergroup"
+		|| type == "private_channel"
+		|| type == "public_channel") {
+		return peerFromChannel(ChannelId(BareId(id)));
+	}
+	return PeerId(0);
+}
+
+// Reads only the chat ids and message ids from an exported result.json,
+// without building any document tree for the (possibly huge) file.
+void ScanExportedMessageIds(
+		const char *from,
+		const char *till,
+		std::map<PeerId, Data::ExportedMessageIds> &result) {
+	auto stack = std::vector<ScanFrame>();
+	auto expectKey = false;
+	const auto open = [&](bool object) {
+		auto frame = ScanFrame{ .object = object };
+		if (!stack.empty()) {
+			const auto &parent = stack.back();
+			if (parent.object && !object && parent.key == "messages") {
+				frame.messages = true;
+				stack.back().hasMessages = true;
+			} else if (parent.messages && object) {
+				frame.message = true;
+			}
+		}
+		stack.push_back(std::move(frame));
+		expectKey = object;
+	};
+	const auto close = [&] {
+		if (stack.empty()) {
+			return;
+		}
+		const auto frame = std::move(stack.back());
+		stack.pop_back();
+		expectKey = false;
+		if (!frame.object || !frame.hasMessages || !frame.id) {
+			return;
+		}
+		const auto peerId = ScannedChatPeerId(frame.type, *frame.id);
+		if (!peerId) {
+			return;
+		}
+		auto &ids = result[peerId];
+		ids.lastId = std::max(ids.lastId, frame.ids.lastId);
+		ids.lastMigratedId = std::max(
+			ids.lastMigratedId,
+			frame.ids.lastMigratedId);
+	};
+	const auto number = [&](int64 value) {
+		if (stack.empty() || !stack.back().object) {
+			return;
+		}
+		auto &frame = stack.back();
+		if (frame.key != "id") {
+			return;
+		}
+		frame.id = value;
+		if (!frame.message || stack.size() < 3) {
+			return;
+		}
+		auto &chat = stack[stack.size() - 3].ids;
+		if (value > 0) {
+			chat.lastId = std::max(chat.lastId, int32(value));
+		} else if (value > Data::kMigratedMessagesIdShift) {
+			chat.lastMigratedId = std::max(
+				chat.lastMigratedId,
+				int32(value - Data::kMigratedMessagesIdShift));
+		}
+	};
+	const auto string = [&](QByteArray &&value) {
+		if (stack.empty() || !stack.back().object) {
+			return;
+		}
+		auto &frame = stack.back();
+		if (expectKey) {
+			frame.key = std::move(value);
+			expectKey = false;
+		} else if (frame.key == "type") {
+			frame.type = std::move(value);
+		}
+	};
+
+	auto p = from;
+	while (p != till) {
+		switch (*p) {
+		case '{': open(true); ++p; break;
+		case '[': open(false); ++p; break;
+		case '}':
+		case ']': close(); ++p; break;
+		case ',':
+			expectKey = !stack.empty() && stack.back().object;
+			++p;
+			break;
+		case '"': {
+			const auto start = ++p;
+			while (p != till && *p != '"') {
+				if (*p == '\\' && p + 1 != till) {
+					++p;
+				}
+				++p;
+			}
+			auto value = QByteArray(start, p - start);
+			if (p != till) {
+				++p;
+			}
+			string(std::move(value));
+		} break;
+		case '-':
+		case '0': case '1': case '2': case '3': case '4':
+		case '5': case '6': case '7': case '8': case '9': {
+			const auto start = p;
+			while (p != till
+				&& ((*p >= '0' && *p <= '9')
+					|| *p == '-'
+					|| *p == '+'
+					|| *p == '.'
+					|| *p == 'e'
+					|| *p == 'E')) {
+				++p;
+			}
+			auto ok = false;
+			const auto value = QByteArray::fromRawData(
+				start,
+				p - start).toLongLong(&ok);
+			if (ok) {
+				number(value);
+			}
+		} break;
+		default: ++p; break;
+		}
+	}
+}
+
+void ScanExportedFile(
+		const QString &path,
+		std::map<PeerId, Data::ExportedMessageIds> &result) {
+	auto file = QFile(path);
+	if (!file.open(QIODevice::ReadOnly)) {
+		return;
+	}
+	const auto size = file.size();
+	const auto data = size ? file.map(0, size) : nullptr;
+	if (!data) {
+		LOG(("Export Error: Could not map '%1' for incremental export."
+			).arg(path));
+		return;
+	}
+	const auto from = reinterpret_cast<const char*>(data);
+	ScanExportedMessageIds(from, from + size, result);
+	file.unmap(data);
+}
+
 } // namespace
 
 Result JsonWriter::start(
@@ -1108,19 +1293,64 @@ Result JsonWriter::validateDialogsMode(bool isLeftChannel) {
 			: _environment.aboutChats));
 }
 
+std::vector<QByteArray> JsonWriter::serializeMessages(
+		const Data::MessagesSlice &data) const {
+	auto messages = std::vector<const Data::Message*>();
+	messages.reserve(data.list.size());
+	for (const auto &message : data.list) {
+		if (!Data::SkipMessageByDate(message, _settings)) {
+			messages.push_back(&message);
+		}
+	}
+	const auto count = int(messages.size());
+	auto result = std::vector<QByteArray>(count);
+	const auto serializeRange = [&](int from, int till) {
+		// Each task works with its own copy of the nesting context.
+		auto context = _context;
+		for (auto i = from; i != till; ++i) {
+			result[i] = SerializeMessage(
+				context,
+				*messages[i],
+				data.peers,
+				_environment.internalLinksDomain);
+		}
+	};
+	const auto tasks = std::clamp(
+		std::min(
+			count / kMessagesInSerializeTask,
+			QThread::idealThreadCount()),
+		1,
+		kMaxSerializeTasks);
+	if (tasks == 1) {
+		serializeRange(0, count);
+		return result;
+	}
+
+	// Messages are independent, so they are formatted in parallel
+	// and glued in the original order, the output stays the same.
+	const auto perTask = (count + tasks - 1) / tasks;
+	auto semaphore = crl::semaphore();
+	for (auto task = 1; task != tasks; ++task) {
+		const auto from = std::min(task * perTask, count);
+		const auto till = std::min(from + perTask, count);
+		crl::async([&, from, till] {
+			serializeRange(from, till);
+			semaphore.release();
+		});
+	}
+	serializeRange(0, std::min(perTask, count));
+	for (auto task = 1; task != tasks; ++task) {
+		semaphore.acquire();
+	}
+	return result;
+}
+
 Result JsonWriter::writeDialogSlice(const Data::MessagesSlice &data) {
 	Expects(_output != nullptr);
 
 	auto block = QByteArray();
-	for (const auto &message : data.list) {
-		if (Data::SkipMessageByDate(message, _settings)) {
-			continue;
-		}
-		block.append(prepareArrayItemStart() + SerializeMessage(
-			_context,
-			message,
-			data.peers,
-			_environment.internalLinksDomain));
+	for (auto &serialized : serializeMessages(data)) {
+		block.append(prepareArrayItemStart() + serialized);
 	}
 	return block.isEmpty() ? Result::Success() : _output->writeBlock(block);
 }
@@ -1188,5 +1418,31 @@ std::unique_ptr<File> JsonWriter::fileWithRelativePath(
 	return std::make_unique<File>(pathWithRelativePath(path), _stats);
 }
 
+auto ReadExportedMessageIds(const QString &folder)
+-> std::map<PeerId, Data::ExportedMessageIds> {
+	auto result = std::map<PeerId, Data::ExportedMessageIds>();
+	const auto base = QDir(folder);
+	if (!base.exists()) {
+		return result;
+	}
+	const auto read = [&](const QString &path) {
+		if (!Journal::Exists(path)) {
+			ScanExportedFile(path + "result.json", result);
+		}
+	};
+	const auto path = base.absolutePath();
+	read(path.endsWith('/') ? path : (path + '/'));
+	const auto list = base.entryInfoList(
+		QDir::Dirs | QDir::NoDotAndDotDot);
+	for (const auto &entry : list) {
+		const auto name = entry.fileName();
+		if (name.startsWith("DataExport_")
+			|| name.startsWith("ChatExport_")) {
+			read(entry.absoluteFilePath() + '/');
+		}
+	}
+	return result;
+}
+
 } // namespace Output
 } // namespace Export
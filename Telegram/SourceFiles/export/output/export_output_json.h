@@ -72,6 +72,8 @@ private:
 	[[nodiscard]] QByteArray prepareObjectItemStart(const QByteArray &key);
 	[[nodiscard]] QByteArray prepareArrayItemStart();
 	[[nodiscard]] QByteArray popNesting();
+	[[nodiscard]] std::vector<QByteArray> serializeMessages(
+		const Data::MessagesSlice &data) const;
 
 	[[nodiscard]] QString mainFileRelativePath() const;
 	[[nodiscard]] QString pathWithRelativePath(const QString &path) const;
@@ -102,5 +104,10 @@ private:
 
 };
 
+// Largest message ids of every chat in the finished JSON exports found
+// in the folder itself and in its DataExport_ / ChatExport_ subfolders.
+[[nodiscard]] auto ReadExportedMessageIds(const QString &folder)
+-> std::map<PeerId, Data::ExportedMessageIds>;
+
 } // namespace Output
 } // namespace Export
@@ -274,6 +274,25 @@ void SettingsWidget::setupPathAndFormat(
 	addLocationLabel(container);
 	addFormatOption(tr::lng_export_option_html(tr::now), Format::Html);
 	addFormatOption(tr::lng_export_option_json(tr::now), Format::Json);
+
+	const auto incremental = container->add(
+		object_ptr<Ui::SlideWrap<Ui::Checkbox>>(
+			container,
+			object_ptr<Ui::Checkbox>(
+				container,
+				tr::lng_export_option_incremental(tr::now),
+				readData().incremental,
+				st::defaultBoxCheckbox),
+			st::exportSubSettingPadding));
+	incremental->entity()->checkedChanges(
+	) | rpl::start_with_next([=](bool checked) {
+		changeData([&](Settings &data) {
+			data.incremental = checked;
+		});
+	}, incremental->lifetime());
+	incremental->toggleOn(value() | rpl::map([](const Settings &data) {
+		return (data.format == Format::Json);
+	}) | rpl::distinct_until_changed());
 }
 
 void SettingsWidget::addLocationLabel(
@@ -56,6 +56,10 @@ constexpr auto kNewBlockEachMessage = 50;
 constexpr auto kSkipCloudDraftsFor = TimeId(2);
 constexpr auto kSendingDraftTime = TimeId(-1);
 
+// On width change only that many views around the scroll position are
+// resized at once, the rest are resized in next batches, nearest first.
+constexpr auto kResizeViewsBatch = 100;
+
 using UpdateFlag = Data::HistoryUpdate::Flag;
 
 } // namespace
@@ -66,7 +70,8 @@ History::History(not_null<Data::Session*> owner, PeerId peerId)
 , cloudDraftTextCache(st::dialogsTextWidthMin)
 , _mute(owner->notifyIsMuted(peer))
 , _chatListNameSortKey(owner->nameSortKey(peer->name))
-, _sendActionPainter(this) {
+, _sendActionPainter(this)
+, _resizeLazyTimer([=] { resizeLazyViews(); }) {
 	if (const auto user = peer->asUser()) {
 		if (user->isBot()) {
 			_outboxReadBefore = std::numeric_limits<MsgId>::max();
@@ -1254,8 +1259,55 @@ void History::addNewerSlice(const QVector<MTPMessage> &slice) {
 	checkLastMessage();
 }
 
+void History::addCachedSlice(const QVector<MTPMessage> &slice) {
+	Expects(isEmpty());
+
+	for (const auto &message : slice) {
+		const auto id = IdFromMessage(message);
+		if (id && !owner().message(channelId(), id)) {
+			_cachedSliceIds.emplace(id);
+		}
+	}
+	if (const auto added = createItems(slice); !added.empty()) {
+		startBuildingFrontBlock(added.size());
+		for (const auto item : added) {
+			addItemToBlock(item);
+		}
+		finishBuildingFrontBlock();
+	}
+}
+
+void History::replaceCachedSlice(const QVector<MTPMessage> &actual) {
+	auto cached = base::take(_cachedSliceIds);
+	for (const auto &message : actual) {
+		// Items created from the cache could be changed on the server.
+		if (cached.remove(IdFromMessage(message))) {
+			owner().updateEditedMessage(message);
+		}
+	}
+	for (const auto id : cached) {
+		if (const auto item = owner().message(channelId(), id)) {
+			item->destroy();
+		}
+	}
+}
+
+void History::destroyCachedSlice() {
+	for (const auto id : base::take(_cachedSliceIds)) {
+		if (const auto item = owner().message(channelId(), id)) {
+			item->destroy();
+		}
+	}
+}
+
+bool History::hasCachedSlice() const {
+	return !_cachedSliceIds.empty();
+}
+
 void History::checkLastMessage() {
-	if (const auto last = lastMessage()) {
+	if (hasCachedSlice()) {
+		return;
+	} else if (const auto last = lastMessage()) {
 		if (!_loadedAtBottom && last->mainView()) {
 			_loadedAtBottom = true;
 			checkAddAllToUnreadMentions();
@@ -2685,20 +2737,64 @@ HistoryItem *History::lastEditableMessage() const {
 }
 
 void History::resizeToWidth(int newWidth) {
-	const auto resizeAllItems = (_width != newWidth);
+	// Full resize is required for the first layout and after
+	// forceFullResize(), otherwise it is done lazily on width change.
+	const auto resizeAllItems = !_width;
+	const auto widthChanged = (_width != newWidth);
 
-	if (!resizeAllItems && !hasPendingResizedItems()) {
+	if (!widthChanged && !hasPendingResizedItems()) {
 		return;
 	}
 	_flags &= ~(Flag::f_has_pending_resized_items);
 
 	_width = newWidth;
+	if (!resizeAllItems) {
+		resizeNearScrollTop(newWidth, kResizeViewsBatch);
+	}
+	auto hasLazyViews = false;
 	int y = 0;
 	for (const auto &block : blocks) {
 		block->setY(y);
-		y += block->resizeGetHeight(newWidth, resizeAllItems);
+		y += block->resizeGetHeight(newWidth, resizeAllItems, hasLazyViews);
 	}
 	_height = y;
+	if (hasLazyViews) {
+		_resizeLazyTimer.callOnce(0);
+	} else {
+		_resizeLazyTimer.cancel();
+	}
+}
+
+void History::resizeNearScrollTop(int newWidth, int limit) {
+	// The visible area is below scrollTopItem or at the very bottom.
+	auto below = scrollTopItem
+		? scrollTopItem
+		: blocks.empty()
+		? nullptr
+		: blocks.back()->messages.back().get();
+	auto above = below ? below->previousInBlocks() : nullptr;
+	const auto resize = [&](not_null<Element*> view) {
+		if (view->pendingResize() || view->width() != newWidth) {
+			view->resizeGetHeight(newWidth);
+			--limit;
+		}
+	};
+	while (limit > 0 && (above || below)) {
+		if (below) {
+			resize(below);
+			below = below->nextInBlocks();
+		}
+		if (above && limit > 0) {
+			resize(above);
+			above = above->previousInBlocks();
+		}
+	}
+}
+
+void History::resizeLazyViews() {
+	// Next batch is resized in resizeToWidth() with the same width.
+	owner().notifyHistoryChangeDelayed(this);
+	owner().sendHistoryChangeNotifications();
 }
 
 void History::forceFullResize() {
@@ -2998,6 +3094,8 @@ void History::clear(ClearType type) {
 	if (type == ClearType::Unload) {
 		_loadedAtTop = _loadedAtBottom = false;
 	} else {
+		_cachedSliceIds.clear();
+
 		// Leave the 'sending' messages in local messages.
 		auto local = base::flat_set<not_null<HistoryItem*>>();
 		for (const auto item : _localMessages) {
@@ -3101,13 +3199,20 @@ HistoryBlock::HistoryBlock(not_null<History*> history)
 : _history(history) {
 }
 
-int HistoryBlock::resizeGetHeight(int newWidth, bool resizeAllItems) {
+int HistoryBlock::resizeGetHeight(
+		int newWidth,
+		bool resizeAllItems,
+		bool &hasLazyViews) {
 	auto y = 0;
 	for (const auto &message : messages) {
 		message->setY(y);
 		if (resizeAllItems || message->pendingResize()) {
 			y += message->resizeGetHeight(newWidth);
 		} else {
+			if (message->width() != newWidth) {
+				// Keep the old height until it is resized in a next batch.
+				hasLazyViews = true;
+			}
 			y += message->height();
 		}
 	}
@@ -178,6 +178,14 @@ public:
 	void addOlderSlice(const QVector<MTPMessage> &slice);
 	void addNewerSlice(const QVector<MTPMessage> &slice);
 
+	// The slice from the local cache is only shown, it doesn't affect
+	// the last message, shared media or unread mentions until it is
+	// replaced by the actual slice from the server.
+	void addCachedSlice(const QVector<MTPMessage> &slice);
+	void replaceCachedSlice(const QVector<MTPMessage> &actual);
+	void destroyCachedSlice();
+	[[nodiscard]] bool hasCachedSlice() const;
+
 	void newItemAdded(not_null<HistoryItem*> item);
 
 	void registerLocalMessage(not_null<HistoryItem*> item);
@@ -542,6 +550,9 @@ private:
 
 	void setFolderPointer(Data::Folder *folder);
 
+	void resizeNearScrollTop(int newWidth, int limit);
+	void resizeLazyViews();
+
 	Flags _flags = 0;
 	bool _mute = false;
 	int _width = 0;
@@ -551,6 +562,7 @@ private:
 	HistoryService *_joinedMessage = nullptr;
 	bool _loadedAtTop = false;
 	bool _loadedAtBottom = true;
+	base::flat_set<MsgId> _cachedSliceIds;
 
 	std::optional<Data::Folder*> _folder;
 
@@ -592,6 +604,7 @@ private:
 	QString _topPromotedType;
 
 	HistoryView::SendActionPainter _sendActionPainter;
+	base::Timer _resizeLazyTimer;
 
 	std::deque<not_null<HistoryItem*>> _notifications;
 
@@ -611,7 +624,10 @@ public:
 	void remove(not_null<Element*> view);
 	void refreshView(not_null<Element*> view);
 
-	int resizeGetHeight(int newWidth, bool resizeAllItems);
+	int resizeGetHeight(
+		int newWidth,
+		bool resizeAllItems,
+		bool &hasLazyViews);
 	int y() const {
 		return _y;
 	}
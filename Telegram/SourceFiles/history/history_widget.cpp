@@ -1770,6 +1770,19 @@ void HistoryWidget::showHistory(
 
 	clearHighlightMessages();
 	hideInfoTooltip(anim::type::instant);
+
+	// Previous histories are reported closed only after the new ones are
+	// reported opened, so that a history being opened is never unloaded
+	// as the least recently closed one right before it is shown.
+	auto wasOpened = std::vector<not_null<History*>>();
+	const auto closeWasOpened = [&] {
+		auto &histories = session().data().histories();
+		for (const auto history : base::take(wasOpened)) {
+			if (history != _history && history != _migrated) {
+				histories.historyClosed(history);
+			}
+		}
+	};
 	if (_history) {
 		if (_peer->id == peerId && !reload) {
 			updateForwarding();
@@ -1874,6 +1887,10 @@ void HistoryWidget::showHistory(
 		_scrollToAnimation.stop();
 
 		clearAllLoadRequests();
+		if (_migrated) {
+			wasOpened.push_back(_migrated);
+		}
+		wasOpened.push_back(_history);
 		_history = _migrated = nullptr;
 		_list = nullptr;
 		_peer = nullptr;
@@ -1940,6 +1957,9 @@ void HistoryWidget::showHistory(
 	noSelectingScroll();
 	_nonEmptySelection = false;
 
+	if (!_peer) {
+		closeWasOpened();
+	}
 	if (_peer) {
 		_history = _peer->owner().history(_peer);
 		_migrated = _history->migrateFrom();
@@ -1948,6 +1968,12 @@ void HistoryWidget::showHistory(
 			&& (!_history->loadedAtTop() || !_migrated->loadedAtBottom())) {
 			_migrated->clear(History::ClearType::Unload);
 		}
+		auto &histories = session().data().histories();
+		histories.historyOpened(_history);
+		if (_migrated) {
+			histories.historyOpened(_migrated);
+		}
+		closeWasOpened();
 		_history->setFakeUnreadWhileOpened(true);
 
 		if (_showAtMsgId == ShowForChooseMessagesMsgId) {
@@ -2092,6 +2118,11 @@ void HistoryWidget::clearAllLoadRequests() {
 		histories.cancelRequest(_firstLoadRequest);
 		_firstLoadRequest = 0;
 	}
+	if (_cachedSliceRequest) {
+		histories.cancelRequest(_cachedSliceRequest);
+		_cachedSliceRequest = 0;
+		_history->destroyCachedSlice();
+	}
 	if (_preloadRequest) {
 		histories.cancelRequest(_preloadRequest);
 		_preloadRequest = 0;
@@ -2520,6 +2551,10 @@ void HistoryWidget::messagesFailed(const MTP::Error &error, int requestId) {
 	} else if (_firstLoadRequest == requestId) {
 		_firstLoadRequest = 0;
 		controller()->showBackFromStack();
+	} else if (_cachedSliceRequest == requestId) {
+		_cachedSliceRequest = 0;
+		_history->destroyCachedSlice();
+		controller()->showBackFromStack();
 	} else if (_delayedShowAtRequest == requestId) {
 		_delayedShowAtRequest = 0;
 	}
@@ -2536,6 +2571,8 @@ void HistoryWidget::messagesReceived(PeerData *peer, const MTPmessages_Messages
 			_preloadDownRequest = 0;
 		} else if (_firstLoadRequest == requestId) {
 			_firstLoadRequest = 0;
+		} else if (_cachedSliceRequest == requestId) {
+			_cachedSliceRequest = 0;
 		} else if (_delayedShowAtRequest == requestId) {
 			_delayedShowAtRequest = 0;
 		}
@@ -2602,6 +2639,26 @@ void HistoryWidget::messagesReceived(PeerData *peer, const MTPmessages_Messages
 			return;
 		}
 
+		historyLoaded();
+	} else if (_cachedSliceRequest == requestId) {
+		// Replace the slice shown from the local cache with the actual one.
+		_cachedSliceRequest = 0;
+		if (_delayedShowAtRequest) {
+			_history->replaceCachedSlice(*histList);
+			return;
+		}
+		clearAllLoadRequests();
+		_firstLoadRequest = -1; // hack - don't updateListSize yet
+		_history->clear(History::ClearType::Unload);
+		_history->replaceCachedSlice(*histList);
+		_history->getReadyFor(ShowAtTheEndMsgId);
+		addMessagesToFront(peer, *histList);
+		_firstLoadRequest = 0;
+
+		if (_history->loadedAtTop() && _history->isEmpty() && count > 0) {
+			firstLoadMessages();
+			return;
+		}
 		historyLoaded();
 	} else if (_delayedShowAtRequest == requestId) {
 		if (toMigrated) {
@@ -2642,6 +2699,26 @@ void HistoryWidget::messagesReceived(PeerData *peer, const MTPmessages_Messages
 	}
 }
 
+void HistoryWidget::cachedMessagesReceived(
+		not_null<History*> history,
+		const QVector<MTPMessage> &messages,
+		int requestId) {
+	if (_history != history
+		|| _firstLoadRequest != requestId
+		|| !_history->isEmpty()
+		|| !_history->loadedAtBottom()) {
+		return;
+	}
+	_history->addCachedSlice(messages);
+	if (_history->isEmpty()) {
+		return;
+	}
+
+	// Keep the network request alive to reconcile the cached slice.
+	_cachedSliceRequest = base::take(_firstLoadRequest);
+	historyLoaded();
+}
+
 void HistoryWidget::historyLoaded() {
 	_historyInited = false;
 	doneShow();
@@ -2652,7 +2729,10 @@ void HistoryWidget::windowShown() {
 }
 
 bool HistoryWidget::doWeReadServerHistory() const {
-	return doWeReadMentions() && !session().supportMode();
+	// Don't read by the ids from the cached slice until it is replaced.
+	return doWeReadMentions()
+		&& !_cachedSliceRequest
+		&& !session().supportMode();
 }
 
 bool HistoryWidget::doWeReadMentions() const {
@@ -2718,6 +2798,13 @@ void HistoryWidget::firstLoadMessages() {
 
 	const auto history = from;
 	const auto type = Data::Histories::RequestType::History;
+	const auto cacheable = (history == _history)
+		&& !_migrated
+		&& !offsetId
+		&& !offset
+		&& _history->isEmpty()
+		&& _history->loadedAtBottom();
+	const auto requestId = std::make_shared<int>();
 	auto &histories = history->owner().histories();
 	_firstLoadRequest = histories.sendRequest(history, type, [=](Fn<void()> finish) {
 		return history->session().api().request(MTPmessages_GetHistory(
@@ -2730,13 +2817,23 @@ void HistoryWidget::firstLoadMessages() {
 			MTP_int(minId),
 			MTP_int(historyHash)
 		)).done([=](const MTPmessages_Messages &result) {
-			messagesReceived(history->peer, result, _firstLoadRequest);
+			if (cacheable) {
+				history->owner().histories().cacheSlice(history, result);
+			}
+			messagesReceived(history->peer, result, *requestId);
 			finish();
 		}).fail([=](const MTP::Error &error) {
-			messagesFailed(error, _firstLoadRequest);
+			messagesFailed(error, *requestId);
 			finish();
 		}).send();
 	});
+	*requestId = _firstLoadRequest;
+	if (cacheable) {
+		histories.readCachedSlice(history, crl::guard(this, [=](
+				const QVector<MTPMessage> &messages) {
+			cachedMessagesReceived(history, messages, *requestId);
+		}));
+	}
 }
 
 void HistoryWidget::loadMessages() {
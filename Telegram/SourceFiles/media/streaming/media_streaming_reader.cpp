@@ -21,7 +21,11 @@ constexpr auto kInSlice = kPartsInSlice * kPartSize;
 constexpr auto kMaxPartsInHeader = 64;
 constexpr auto kMaxOnlyInHeader = 80 * kPartSize;
 constexpr auto kPartsOutsideFirstSliceGood = 8;
-constexpr auto kSlicesInMemory = 2;
+
+// Recently used slices are kept in memory up to this limit, so that
+// scrubbing back and forth doesn't re-read them from the disk cache.
+constexpr auto kSlicesInMemoryLimit = 40 * 1024 * 1024;
+constexpr auto kSlicesInMemory = std::max(kSlicesInMemoryLimit / kInSlice, 2);
 
 // 1 MB of parts are requested from cloud ahead of reading demand.
 constexpr auto kPreloadPartsAhead = 8;
@@ -450,6 +454,10 @@ void Reader::Slices::processCacheResult(int sliceNumber, PartsMap &&result) {
 	}
 	slice.processCacheData(std::move(result));
 	checkSliceFullLoaded(sliceNumber);
+	if (sliceNumber) {
+		// Slices prefetched from cache should be unloaded by LRU as well.
+		markSliceUsed(sliceNumber - 1);
+	}
 	if (!sliceNumber) {
 		applyHeaderCacheData();
 		if (isGoodHeader()) {
@@ -619,6 +627,7 @@ auto Reader::Slices::fill(int offset, bytes::span buffer) -> FillResult {
 				secondFrom,
 				secondTill);
 		}
+		prefetchFromCache(fromSlice, tillSlice, result);
 		result.toCache = serializeAndUnloadUnused();
 		result.state = FillState::Success;
 	} else {
@@ -630,6 +639,42 @@ auto Reader::Slices::fill(int offset, bytes::span buffer) -> FillResult {
 	return result;
 }
 
+void Reader::Slices::prefetchFromCache(
+		int fromSlice,
+		int tillSlice,
+		FillResult &result) {
+	using Flag = Slice::Flag;
+
+	if (_lastFillSlice >= 0
+		&& fromSlice != _lastFillSlice
+		&& fromSlice != _lastFillSlice + 1) {
+		// Not a sequential read, remember the direction of the seek.
+		_seekedBackward = (fromSlice < _lastFillSlice);
+	}
+	_lastFillSlice = fromSlice;
+
+	if (_headerMode == HeaderMode::NoCache
+		|| _headerMode == HeaderMode::Unknown) {
+		return;
+	}
+	const auto prefetch = [&](int sliceIndex) {
+		if (sliceIndex < 0 || sliceIndex >= int(_data.size())) {
+			return;
+		}
+		auto &slice = _data[sliceIndex];
+		if (!(slice.flags & (Flag::LoadedFromCache | Flag::LoadingFromCache))
+			&& result.sliceNumbersFromCache.add(sliceIndex + 1)) {
+			slice.flags |= Flag::LoadingFromCache;
+		}
+	};
+
+	// Playback goes on forward, while scrubbing usually keeps direction.
+	prefetch(tillSlice);
+	if (_seekedBackward) {
+		prefetch(fromSlice - 1);
+	}
+}
+
 auto Reader::Slices::fillFromHeader(int offset, bytes::span buffer)
 -> FillResult {
 	auto result = FillResult();
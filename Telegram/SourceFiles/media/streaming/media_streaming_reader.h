@@ -184,6 +184,10 @@ private:
 			const Slice &slice) const;
 		[[nodiscard]] QByteArray serializeAndUnloadFirstSliceNoHeader();
 		void markSliceUsed(int sliceIndex);
+		void prefetchFromCache(
+			int fromSlice,
+			int tillSlice,
+			FillResult &result);
 		[[nodiscard]] bool computeIsGoodHeader() const;
 		[[nodiscard]] FillResult fillFromHeader(
 			int offset,
@@ -196,6 +200,8 @@ private:
 		Slice _header;
 		std::deque<int> _usedSlices;
 		int _size = 0;
+		int _lastFillSlice = -1;
+		bool _seekedBackward = false;
 		HeaderMode _headerMode = HeaderMode::Unknown;
 		bool _fullInCache = false;
 
@@ -11,11 +11,60 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "ui/image/image_prepare.h"
 #include "ffmpeg/ffmpeg_utility.h"
 
+#include <QtCore/QMutex>
+
 namespace Media {
 namespace Streaming {
 namespace {
 
 constexpr auto kSkipInvalidDataPackets = 10;
+constexpr auto kEllipseMasksLimit = 4;
+
+[[nodiscard]] QImage GenerateEllipseMask(QSize size) {
+	auto result = QImage(size, QImage::Format_ARGB32_Premultiplied);
+	result.fill(Qt::transparent);
+
+	QPainter p(&result);
+	PainterHighQualityEnabler hq(p);
+	p.setPen(Qt::NoPen);
+	p.setBrush(Qt::white);
+	p.drawEllipse(QRect(QPoint(), size));
+	return result;
+}
+
+// Round video frames of the same size are masked on each frame, so the
+// antialiased mask is generated once and shared between the threads.
+[[nodiscard]] QImage EllipseMask(QSize size) {
+	static auto Mutex = QMutex();
+	static auto Masks = std::deque<QImage>();
+
+	QMutexLocker lock(&Mutex);
+	const auto i = ranges::find(Masks, size, &QImage::size);
+	if (i != end(Masks)) {
+		return *i;
+	}
+	if (Masks.size() == kEllipseMasksLimit) {
+		Masks.pop_front();
+	}
+	Masks.push_back(GenerateEllipseMask(size));
+	return Masks.back();
+}
+
+void ApplyEllipseMask(QImage &storage) {
+	Expects(storage.format() == QImage::Format_ARGB32_Premultiplied);
+
+	const auto mask = EllipseMask(storage.size());
+
+	// Composing in device pixels, the raster engine blends DestinationIn
+	// with the best SIMD implementation available at runtime.
+	const auto ratio = storage.devicePixelRatio();
+	storage.setDevicePixelRatio(1.);
+	QPainter p(&storage);
+	p.setCompositionMode(QPainter::CompositionMode_DestinationIn);
+	p.drawImage(0, 0, mask);
+	p.end();
+	storage.setDevicePixelRatio(ratio);
+}
 
 } // namespace
 
@@ -282,6 +331,11 @@ void ApplyFrameRounding(QImage &storage, const FrameRequest &request) {
 	if (!(request.corners & RectPart::AllCorners)
 		|| (request.radius == ImageRoundRadius::None)) {
 		return;
+	} else if (request.radius == ImageRoundRadius::Ellipse
+		&& (request.corners & RectPart::AllCorners) == RectPart::AllCorners
+		&& storage.format() == QImage::Format_ARGB32_Premultiplied) {
+		ApplyEllipseMask(storage);
+		return;
 	}
 	Images::prepareRound(storage, request.radius, request.corners);
 }
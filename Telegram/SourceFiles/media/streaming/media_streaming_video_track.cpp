@@ -21,7 +21,10 @@ constexpr auto kDisplaySkipped = crl::time(-1);
 constexpr auto kFinishedPosition = std::numeric_limits<crl::time>::max();
 static_assert(kDisplaySkipped != kTimeUnknown);
 
-[[nodiscard]] QImage ConvertToARGB32(const FrameYUV420 &data) {
+[[nodiscard]] QImage ConvertToARGB32(
+		const FrameYUV420 &data,
+		QImage storage,
+		FFmpeg::SwscalePointer &swscale) {
 	Expects(data.y.data != nullptr);
 	Expects(data.u.data != nullptr);
 	Expects(data.v.data != nullptr);
@@ -31,13 +34,15 @@ static_assert(kDisplaySkipped != kTimeUnknown);
 	//	resize.transpose();
 	//}
 
-	auto result = FFmpeg::CreateFrameStorage(data.size);
-	const auto format = AV_PIX_FMT_BGRA;
-	const auto swscale = FFmpeg::MakeSwscalePointer(
+	auto result = FFmpeg::GoodStorageForFrame(storage, data.size)
+		? std::move(storage)
+		: FFmpeg::CreateFrameStorage(data.size);
+	swscale = FFmpeg::MakeSwscalePointer(
 		data.size,
 		AV_PIX_FMT_YUV420P,
 		data.size,
-		AV_PIX_FMT_BGRA);
+		AV_PIX_FMT_BGRA,
+		&swscale);
 	if (!swscale) {
 		return QImage();
 	}
@@ -440,7 +445,8 @@ void VideoTrackObject::rasterizeFrame(not_null<Frame*> frame) {
 			return;
 		}
 		if (!frame->original.isNull()) {
-			frame->original = QImage();
+			// Keep the buffer to convert the next frame into it.
+			frame->storage = base::take(frame->original);
 			for (auto &[_, prepared] : frame->prepared) {
 				prepared.image = QImage();
 			}
@@ -452,6 +458,9 @@ void VideoTrackObject::rasterizeFrame(not_null<Frame*> frame) {
 			frame->decoded->width,
 			frame->decoded->height
 		};
+		if (frame->original.isNull()) {
+			frame->original = base::take(frame->storage);
+		}
 		frame->original = ConvertFrame(
 			_stream,
 			frame->decoded.get(),
@@ -1106,7 +1115,10 @@ QImage VideoTrack::frame(
 	}
 	if (frame->original.isNull()
 		&& frame->format == FrameFormat::YUV420) {
-		frame->original = ConvertToARGB32(frame->yuv420);
+		frame->original = ConvertToARGB32(
+			frame->yuv420,
+			base::take(frame->storage),
+			frame->swscale);
 	}
 	if (!frame->alpha
 		&& GoodForRequest(frame->original, _streamRotation, useRequest)) {
@@ -1160,7 +1172,10 @@ FrameWithInfo VideoTrack::frameWithInfo(const Instance *instance) {
 QImage VideoTrack::currentFrameImage() {
 	const auto frame = _shared->frameForPaint();
 	if (frame->original.isNull() && frame->format == FrameFormat::YUV420) {
-		frame->original = ConvertToARGB32(frame->yuv420);
+		frame->original = ConvertToARGB32(
+			frame->yuv420,
+			base::take(frame->storage),
+			frame->swscale);
 	}
 	return frame->original;
 }
@@ -24,6 +24,10 @@ constexpr auto kPacketSizeMax = int(0x01000000 * sizeof(mtpPrime));
 constexpr auto kFullConnectionTimeout = 8 * crl::time(1000);
 constexpr auto kSmallBufferSize = 256 * 1024;
 constexpr auto kMinPacketBuffer = 256;
+
+// Large buffer is kept between packets, so that a sequence of file parts
+// doesn't allocate and zero-fill a new buffer for each of them.
+constexpr auto kKeepLargeBufferSize = 2 * 1024 * 1024;
 constexpr auto kConnectionStartPrefixSize = 64;
 
 } // namespace
@@ -248,17 +252,21 @@ void TcpConnection::ensureAvailableInBuffer(int amount) {
 		return;
 	}
 	const auto read = full.subspan(0, _readBytes);
+	_movedBytes += read.size();
 	if (amount <= _smallBuffer.size()) {
 		if (_usingLargeBuffer) {
 			bytes::copy(_smallBuffer, read);
-			_usingLargeBuffer = false;
-			_largeBuffer.clear();
+			releaseLargeBuffer();
 		} else {
 			bytes::move(_smallBuffer, read);
 		}
 	} else if (amount <= _largeBuffer.size()) {
-		Assert(_usingLargeBuffer);
-		bytes::move(_largeBuffer, read);
+		if (_usingLargeBuffer) {
+			bytes::move(_largeBuffer, read);
+		} else {
+			bytes::copy(_largeBuffer, read);
+			_usingLargeBuffer = true;
+		}
 	} else {
 		auto enough = bytes::vector(amount);
 		bytes::copy(enough, read);
@@ -268,6 +276,13 @@ void TcpConnection::ensureAvailableInBuffer(int amount) {
 	_offsetBytes = 0;
 }
 
+void TcpConnection::releaseLargeBuffer() {
+	_usingLargeBuffer = false;
+	if (_largeBuffer.size() > kKeepLargeBufferSize) {
+		_largeBuffer = bytes::vector();
+	}
+}
+
 void TcpConnection::socketRead() {
 	Expects(_leftBytes > 0 || !_usingLargeBuffer);
 
@@ -292,9 +307,10 @@ void TcpConnection::socketRead() {
 		const auto readCount = _socket->read(free.subspan(0, readLimit));
 		if (readCount > 0) {
 			const auto read = free.subspan(0, readCount);
-			aesCtrEncrypt(read, _receiveKey, &_receiveState);
+			_receiveStream.encrypt(read);
 			TCP_LOG(("TCP Info: read %1 bytes").arg(readCount));
 
+			_receivedBytes += readCount;
 			_readBytes += readCount;
 			if (_leftBytes > 0) {
 				Assert(readCount <= _leftBytes);
@@ -305,8 +321,7 @@ void TcpConnection::socketRead() {
 						return;
 					}
 
-					_usingLargeBuffer = false;
-					_largeBuffer.clear();
+					releaseLargeBuffer();
 					_offsetBytes = _readBytes = 0;
 				} else {
 					TCP_LOG(("TCP Info: not enough %1 for packet! read %2"
@@ -391,6 +406,7 @@ mtpBuffer TcpConnection::parsePacket(bytes::const_span bytes) {
 	}
 	auto result = mtpBuffer(ints.size());
 	memcpy(result.data(), ints.data(), ints.size() * sizeof(mtpPrime));
+	_movedBytes += ints.size() * sizeof(mtpPrime);
 	return result;
 }
 
@@ -427,7 +443,7 @@ void TcpConnection::sendData(mtpBuffer &&buffer) {
 	// buffer: 2 available int-s + data + available int.
 	const auto bytes = _protocol->finalizePacket(buffer);
 	TCP_LOG(("TCP Info: write packet %1 bytes").arg(bytes.size()));
-	aesCtrEncrypt(bytes, _sendKey, &_sendState);
+	_sendStream.encrypt(bytes);
 	_socket->write(connectionStartPrefix, bytes);
 }
 
@@ -449,11 +465,10 @@ bytes::const_span TcpConnection::prepareConnectionStartPrefix(
 	} while (!_socket->isGoodStartNonce(nonce));
 
 	// prepare encryption key/iv
-	_protocol->prepareKey(
-		bytes::make_span(_sendKey),
-		nonce.subspan(8, CTRState::KeySize));
-	bytes::copy(
-		bytes::make_span(_sendState.ivec),
+	auto key = bytes::array<CTRState::KeySize>();
+	_protocol->prepareKey(key, nonce.subspan(8, CTRState::KeySize));
+	_sendStream = CTRStream(
+		key,
 		nonce.subspan(8 + CTRState::KeySize, CTRState::IvecSize));
 
 	// prepare decryption key/iv
@@ -461,11 +476,9 @@ bytes::const_span TcpConnection::prepareConnectionStartPrefix(
 	const auto reversed = bytes::make_span(reversedBytes);
 	bytes::copy(reversed, nonce.subspan(8, reversed.size()));
 	std::reverse(reversed.begin(), reversed.end());
-	_protocol->prepareKey(
-		bytes::make_span(_receiveKey),
-		reversed.subspan(0, CTRState::KeySize));
-	bytes::copy(
-		bytes::make_span(_receiveState.ivec),
+	_protocol->prepareKey(key, reversed.subspan(0, CTRState::KeySize));
+	_receiveStream = CTRStream(
+		key,
 		reversed.subspan(CTRState::KeySize, CTRState::IvecSize));
 
 	// write protocol and dc ids
@@ -475,7 +488,7 @@ bytes::const_span TcpConnection::prepareConnectionStartPrefix(
 	*dcId = _protocolDcId;
 
 	bytes::copy(buffer, nonce.subspan(0, 56));
-	aesCtrEncrypt(nonce, _sendKey, &_sendState);
+	_sendStream.encrypt(nonce);
 	bytes::copy(buffer.subspan(56), nonce.subspan(56));
 
 	return buffer;
@@ -489,6 +502,13 @@ void TcpConnection::disconnectFromServer() {
 	_connectedLifetime.destroy();
 	_lifetime.destroy();
 	_socket = nullptr;
+
+	if (_receivedBytes > 0) {
+		DEBUG_LOG(("TCP Info: dc:%1 - received %2 bytes, copied %3 bytes."
+			).arg(_protocolDcId
+			).arg(_receivedBytes
+			).arg(_movedBytes));
+	}
 }
 
 void TcpConnection::connectToServer(
@@ -571,7 +591,7 @@ void TcpConnection::socketPacket(bytes::const_span bytes) {
 	Expects(_socket != nullptr);
 
 	// old quickack?..
-	const auto data = parsePacket(bytes);
+	auto data = parsePacket(bytes);
 	if (data.size() == 1) {
 		if (data[0] != 0) {
 			error(data[0]);
@@ -581,7 +601,7 @@ void TcpConnection::socketPacket(bytes::const_span bytes) {
 	//} else if (data.size() == 2) {
 		// new quickack?..
 	} else if (_status == Status::Ready) {
-		_receivedQueue.push_back(data);
+		_receivedQueue.push_back(std::move(data));
 		receivedData();
 	} else if (_status == Status::Waiting) {
 		if (const auto res_pq = readPQFakeReply(data)) {
@@ -62,6 +62,7 @@ private:
 
 	mtpBuffer parsePacket(bytes::const_span bytes);
 	void ensureAvailableInBuffer(int amount);
+	void releaseLargeBuffer();
 	static uint32 fourCharsToUInt(char ch1, char ch2, char ch3, char ch4) {
 		char ch[4] = { ch1, ch2, ch3, ch4 };
 		return *reinterpret_cast<uint32*>(ch);
@@ -78,10 +79,12 @@ private:
 	bytes::vector _largeBuffer;
 	bool _usingLargeBuffer = false;
 
-	uchar _sendKey[CTRState::KeySize];
-	CTRState _sendState;
-	uchar _receiveKey[CTRState::KeySize];
-	CTRState _receiveState;
+	// Bytes copied inside the client per byte received from the socket.
+	int64 _receivedBytes = 0;
+	int64 _movedBytes = 0;
+
+	CTRStream _sendStream;
+	CTRStream _receiveStream;
 	class Protocol;
 	std::unique_ptr<Protocol> _protocol;
 	int16 _protocolDcId = 0;
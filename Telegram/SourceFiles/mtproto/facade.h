@@ -40,7 +40,7 @@ constexpr ShiftedDcId groupCallStreamDcId(DcId dcId) {
 	return ShiftDcId(dcId, kGroupCallStreamDcShift);
 }
 
-constexpr auto kUploadSessionsCount = 2;
+constexpr auto kUploadSessionsCount = 4;
 
 namespace details {
 
@@ -168,22 +168,50 @@ void aesIgeDecryptRaw(const void *src, void *dst, uint32 len, const void *key, c
 	AES_ige_encrypt(static_cast<const uchar*>(src), static_cast<uchar*>(dst), len, &aes, aes_iv, AES_DECRYPT);
 }
 
-void aesCtrEncrypt(bytes::span data, const void *key, CTRState *state) {
-	AES_KEY aes;
-	AES_set_encrypt_key(static_cast<const uchar*>(key), 256, &aes);
-
-	static_assert(CTRState::IvecSize == AES_BLOCK_SIZE, "Wrong size of ctr ivec!");
-	static_assert(CTRState::EcountSize == AES_BLOCK_SIZE, "Wrong size of ctr ecount!");
-
-	CRYPTO_ctr128_encrypt(
-		reinterpret_cast<const uchar*>(data.data()),
-		reinterpret_cast<uchar*>(data.data()),
-		data.size(),
-		&aes,
-		state->ivec,
-		state->ecount,
-		&state->num,
-		(block128_f)AES_encrypt);
+CTRStream::CTRStream(bytes::const_span key, bytes::const_span ivec)
+: _context(EVP_CIPHER_CTX_new()) {
+	Expects(key.size() == CTRState::KeySize);
+	Expects(ivec.size() == CTRState::IvecSize);
+	Expects(_context != nullptr);
+
+	EVP_EncryptInit_ex(
+		_context,
+		EVP_aes_256_ctr(),
+		nullptr,
+		reinterpret_cast<const uchar*>(key.data()),
+		reinterpret_cast<const uchar*>(ivec.data()));
+}
+
+CTRStream::CTRStream(CTRStream &&other)
+: _context(base::take(other._context)) {
+}
+
+CTRStream &CTRStream::operator=(CTRStream &&other) {
+	if (this != &other) {
+		if (_context) {
+			EVP_CIPHER_CTX_free(_context);
+		}
+		_context = base::take(other._context);
+	}
+	return *this;
+}
+
+CTRStream::~CTRStream() {
+	if (_context) {
+		EVP_CIPHER_CTX_free(_context);
+	}
+}
+
+void CTRStream::encrypt(bytes::span data) {
+	Expects(_context != nullptr);
+	Expects(data.size() <= std::numeric_limits<int>::max());
+
+	const auto bytes = reinterpret_cast<uchar*>(data.data());
+	const auto size = int(data.size());
+	auto written = 0;
+	EVP_EncryptUpdate(_context, bytes, &written, bytes, size);
+
+	Ensures(written == size);
 }
 
 } // namespace MTP
@@ -11,6 +11,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include <array>
 #include <memory>
 
+struct evp_cipher_ctx_st;
+
 namespace MTP {
 
 class AuthKey {
@@ -110,16 +112,31 @@ inline void aesDecryptLocal(const void *src, void *dst, uint32 len, const AuthKe
 	return aesIgeDecryptRaw(src, dst, len, static_cast<const void*>(&aesKey), static_cast<const void*>(&aesIV));
 }
 
-// ctr used inplace, encrypt the data and leave it at the same place
 struct CTRState {
 	static constexpr int KeySize = 32;
 	static constexpr int IvecSize = 16;
-	static constexpr int EcountSize = 16;
+};
+
+// AES-256-CTR stream, used inplace, encrypt the data and leave it at the
+// same place. The key schedule is prepared once for the whole stream and
+// OpenSSL uses the hardware AES instructions when they are available.
+class CTRStream final {
+public:
+	CTRStream() = default;
+	CTRStream(bytes::const_span key, bytes::const_span ivec);
+	CTRStream(CTRStream &&other);
+	CTRStream &operator=(CTRStream &&other);
+	~CTRStream();
+
+	[[nodiscard]] explicit operator bool() const {
+		return (_context != nullptr);
+	}
+
+	void encrypt(bytes::span data);
+
+private:
+	evp_cipher_ctx_st *_context = nullptr;
 
-	uchar ivec[IvecSize] = { 0 };
-	uint32 num = 0;
-	uchar ecount[EcountSize] = { 0 };
 };
-void aesCtrEncrypt(bytes::span data, const void *key, CTRState *state);
 
 } // namespace MTP
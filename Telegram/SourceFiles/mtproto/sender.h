@@ -15,6 +15,31 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 namespace MTP {
 
 class Sender {
+	struct BatchState {
+		base::flat_set<ShiftedDcId> dcIds;
+		crl::time started = 0;
+		int sent = 0;
+		int left = 0;
+		bool sealed = false;
+		FnMut<void()> finished;
+
+		void requestFinished() {
+			--left;
+			checkFinished();
+		}
+		void checkFinished() {
+			if (!sealed || left > 0) {
+				return;
+			}
+			DEBUG_LOG(("MTP Info: batch of %1 requests finished in %2 ms."
+				).arg(sent
+				).arg(crl::now() - started));
+			if (auto onstack = base::take(finished)) {
+				onstack();
+			}
+		}
+	};
+
 	class RequestBuilder {
 	public:
 		RequestBuilder(const RequestBuilder &other) = delete;
@@ -199,6 +224,48 @@ public:
 		return *_instance;
 	}
 
+	template <typename Request>
+	class SpecificRequestBuilder;
+
+	// Requests sent in one batch wait in the queue until the batch is sent,
+	// so they go in the same containers, and `finished` is called once after
+	// each of them got a response or was cancelled through the sender.
+	class Batch final {
+	public:
+		explicit Batch(
+			not_null<Sender*> sender,
+			FnMut<void()> finished = nullptr)
+		: _sender(sender)
+		, _state(std::make_shared<BatchState>()) {
+			_state->started = crl::now();
+			_state->finished = std::move(finished);
+		}
+		Batch(const Batch &other) = delete;
+		Batch &operator=(const Batch &other) = delete;
+		~Batch() {
+			send();
+		}
+
+		void send() {
+			if (_state->sealed) {
+				return;
+			}
+			_state->sealed = true;
+			for (const auto dcId : _state->dcIds) {
+				_sender->instance().sendAnything(dcId);
+			}
+			_state->checkFinished();
+		}
+
+	private:
+		template <typename Request>
+		friend class SpecificRequestBuilder;
+
+		const not_null<Sender*> _sender;
+		const std::shared_ptr<BatchState> _state;
+
+	};
+
 	template <typename Request>
 	class SpecificRequestBuilder : public RequestBuilder {
 	private:
@@ -287,21 +354,61 @@ public:
 			setAfter(requestId);
 			return *this;
 		}
+		[[nodiscard]] SpecificRequestBuilder &inBatch(
+				const Batch &batch) noexcept {
+			Expects(!batch._state->sealed);
+
+			_batch = batch._state;
+			setCanWait(kBatchCanWait);
+			return *this;
+		}
 
 		mtpRequestId send() {
+			const auto dcId = takeDcId();
+			auto done = takeOnDone();
+			auto fail = takeOnFail();
+			const auto batch = base::take(_batch);
+			if (batch) {
+				++batch->sent;
+				batch->dcIds.emplace(dcId);
+
+				// The request is finished whatever the handlers return,
+				// if it is resent later it is not counted again.
+				const auto sender = this->sender();
+				done = [=, done = std::move(done)](
+						const Response &response) mutable {
+					const auto result = !done || done(response);
+					sender->senderBatchRequestFinished(response.requestId);
+					return result;
+				};
+				fail = [=, fail = std::move(fail)](
+						const Error &error,
+						const Response &response) {
+					const auto result = fail(error, response);
+					sender->senderBatchRequestFinished(response.requestId);
+					return result;
+				};
+			}
 			const auto id = sender()->_instance->send(
 				_request,
-				takeOnDone(),
-				takeOnFail(),
-				takeDcId(),
+				std::move(done),
+				std::move(fail),
+				dcId,
 				takeCanWait(),
 				takeAfter());
 			registerRequest(id);
+			if (batch) {
+				sender()->senderBatchRequestRegister(id, batch);
+			}
 			return id;
 		}
 
 	private:
+		// Long enough for the batch to be filled, it is sent explicitly.
+		static constexpr auto kBatchCanWait = crl::time(1000);
+
 		Request _request;
+		std::shared_ptr<BatchState> _batch;
 
 	};
 
@@ -438,10 +545,29 @@ private:
 		if (it != _requests.cend()) {
 			_requests.erase(it);
 		}
+		senderBatchRequestFinished(requestId);
+	}
+	void senderBatchRequestRegister(
+			mtpRequestId requestId,
+			std::shared_ptr<BatchState> batch) {
+		++batch->left;
+		_batchRequests.emplace(requestId, std::move(batch));
+	}
+	void senderBatchRequestFinished(mtpRequestId requestId) {
+		const auto i = _batchRequests.find(requestId);
+		if (i == end(_batchRequests)) {
+			return;
+		}
+		const auto batch = std::move(i->second);
+		_batchRequests.erase(i);
+		batch->requestFinished();
 	}
 
 	const not_null<Instance*> _instance;
 	base::flat_set<RequestWrap, RequestWrapComparator> _requests;
+	base::flat_map<
+		mtpRequestId,
+		std::shared_ptr<BatchState>> _batchRequests;
 
 };
 
@@ -81,7 +81,7 @@ public:
 	base::flat_map<mtpRequestId, SerializedRequest> &toSendMap() {
 		return _toSend;
 	}
-	base::flat_map<mtpMsgId, SerializedRequest> &haveSentMap() {
+	std::unordered_map<mtpMsgId, SerializedRequest> &haveSentMap() {
 		return _haveSent;
 	}
 	std::vector<Response> &haveReceivedMessages() {
@@ -122,7 +122,9 @@ private:
 	base::flat_map<mtpRequestId, SerializedRequest> _toSend; // map of request_id -> request, that is waiting to be sent
 	QReadWriteLock _toSendLock;
 
-	base::flat_map<mtpMsgId, SerializedRequest> _haveSent; // map of msg_id -> request, that was sent
+	// Hash map of msg_id -> request, that was sent. Acks come in any order,
+	// erasing from the middle of a sorted vector under the lock was O(n).
+	std::unordered_map<mtpMsgId, SerializedRequest> _haveSent;
 	QReadWriteLock _haveSentLock;
 
 	std::vector<Response> _receivedMessages; // list of responses / updates that should be processed in the main thread
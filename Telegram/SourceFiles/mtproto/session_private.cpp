@@ -32,6 +32,7 @@ constexpr auto kMinConnectedTimeout = crl::time(1000);
 constexpr auto kMaxConnectedTimeout = crl::time(8000);
 constexpr auto kMinReceiveTimeout = crl::time(4000);
 constexpr auto kMaxReceiveTimeout = crl::time(64000);
+constexpr auto kUploadReceiveTimeoutMultiplier = 2;
 constexpr auto kMarkConnectionOldTimeout = crl::time(192000);
 constexpr auto kPingDelayDisconnect = 60;
 constexpr auto kPingSendAfter = 30 * crl::time(1000);
@@ -49,6 +50,9 @@ constexpr auto kRequestConfigTimeout = 8 * crl::time(1000);
 // Don't try to handle messages larger than this size.
 constexpr auto kMaxMessageLength = 16 * 1024 * 1024;
 
+// Don't trust the gzip size field for a buffer larger than this.
+constexpr auto kMaxUnpackedSizeHint = 16 * 1024 * 1024;
+
 // How much time passed from send till we resend request or check its state.
 constexpr auto kCheckSentRequestTimeout = 10 * crl::time(1000);
 
@@ -63,6 +67,47 @@ auto SyncTimeRequestDuration = kFastRequestDuration;
 
 using namespace details;
 
+// Returns the bytes of a serialized TL string without copying them.
+[[nodiscard]] bytes::const_span ReadSerializedBytes(
+		const mtpPrime *from,
+		const mtpPrime *end) {
+	if (from >= end) {
+		return {};
+	}
+	const auto start = reinterpret_cast<const uchar*>(from);
+	const auto available = std::size_t(end - from) * sizeof(mtpPrime);
+	auto length = std::size_t(start[0]);
+	auto skip = std::size_t(1);
+	if (length == 254) {
+		length = std::size_t(start[1])
+			| (std::size_t(start[2]) << 8)
+			| (std::size_t(start[3]) << 16);
+		skip = 4;
+	} else if (length > 254) {
+		return {};
+	}
+	if (skip + length > available) {
+		return {};
+	}
+	return bytes::const_span(
+		reinterpret_cast<const bytes::type*>(start + skip),
+		length);
+}
+
+// Last four bytes of a gzip stream hold the unpacked size modulo 2^32.
+[[nodiscard]] std::size_t UnpackedSizeHint(bytes::const_span packed) {
+	if (packed.size() < 4) {
+		return 0;
+	}
+	const auto tail = reinterpret_cast<const uchar*>(
+		packed.data() + packed.size() - 4);
+	const auto result = std::size_t(tail[0])
+		| (std::size_t(tail[1]) << 8)
+		| (std::size_t(tail[2]) << 16)
+		| (std::size_t(tail[3]) << 24);
+	return std::min(result, std::size_t(kMaxUnpackedSizeHint));
+}
+
 [[nodiscard]] QString LogIdsVector(const QVector<MTPlong> &ids) {
 	if (!ids.size()) return "[]";
 	auto idsStr = QString("[%1").arg(ids.cbegin()->v);
@@ -103,7 +148,7 @@ using namespace details;
 void WrapInvokeAfter(
 		SerializedRequest &to,
 		const SerializedRequest &from,
-		const base::flat_map<mtpMsgId, SerializedRequest> &haveSent,
+		const std::unordered_map<mtpMsgId, SerializedRequest> &haveSent,
 		int32 skipBeforeRequest = 0) {
 	const auto afterId = *(mtpMsgId*)(from->after->data() + 4);
 	const auto i = afterId ? haveSent.find(afterId) : haveSent.end();
@@ -142,6 +187,95 @@ void WrapInvokeAfter(
 
 } // namespace
 
+// Keeps the zlib state with its window between responses of a session.
+class SessionPrivate::Inflater final {
+public:
+	Inflater() = default;
+	Inflater(const Inflater &other) = delete;
+	Inflater &operator=(const Inflater &other) = delete;
+	~Inflater();
+
+	[[nodiscard]] mtpBuffer inflate(bytes::const_span packed);
+
+private:
+	[[nodiscard]] bool prepare();
+
+	z_stream _stream = z_stream();
+	bool _initialized = false;
+
+};
+
+SessionPrivate::Inflater::~Inflater() {
+	if (_initialized) {
+		inflateEnd(&_stream);
+	}
+}
+
+bool SessionPrivate::Inflater::prepare() {
+	if (_initialized) {
+		return (inflateReset(&_stream) == Z_OK);
+	}
+	_stream.zalloc = nullptr;
+	_stream.zfree = nullptr;
+	_stream.opaque = nullptr;
+	_stream.avail_in = 0;
+	_stream.next_in = nullptr;
+	const auto res = inflateInit2(&_stream, 16 + MAX_WBITS);
+	if (res != Z_OK) {
+		LOG(("RPC Error: could not init zlib stream, code: %1").arg(res));
+		return false;
+	}
+	_initialized = true;
+	return true;
+}
+
+mtpBuffer SessionPrivate::Inflater::inflate(bytes::const_span packed) {
+	if (!prepare()) {
+		return mtpBuffer();
+	}
+	const auto packedInts = int((packed.size() + sizeof(mtpPrime) - 1)
+		/ sizeof(mtpPrime));
+	const auto hintInts = int(UnpackedSizeHint(packed) / sizeof(mtpPrime));
+
+	// One more int so that the stream ends before the buffer is full.
+	auto result = mtpBuffer(std::max(hintInts + 1, packedInts));
+	_stream.avail_in = uInt(packed.size());
+	_stream.next_in = reinterpret_cast<Bytef*>(
+		const_cast<bytes::type*>(packed.data()));
+	_stream.avail_out = uInt(result.size() * sizeof(mtpPrime));
+	_stream.next_out = reinterpret_cast<Bytef*>(result.data());
+	while (true) {
+		const auto res = ::inflate(&_stream, Z_NO_FLUSH);
+		if (res == Z_STREAM_END) {
+			break;
+		} else if (res != Z_OK) {
+			LOG(("RPC Error: could not unpack gziped data, code: %1").arg(res));
+			DEBUG_LOG(("RPC Error: bad gzip: %1").arg(Logs::mb(packed.data(), packed.size()).str()));
+			return mtpBuffer();
+		} else if (_stream.avail_out) {
+			break;
+		}
+
+		// The size hint was wrong, grow the buffer twice.
+		const auto was = result.size();
+		result.resize(was + std::max(was, packedInts));
+		_stream.avail_out = uInt((result.size() - was) * sizeof(mtpPrime));
+		_stream.next_out = reinterpret_cast<Bytef*>(result.data() + was);
+	}
+	const auto unpacked = uint32(result.size() * sizeof(mtpPrime)
+		- _stream.avail_out);
+	if (unpacked % sizeof(mtpPrime)) {
+		LOG(("RPC Error: bad length of unpacked data %1").arg(unpacked));
+		DEBUG_LOG(("RPC Error: bad unpacked data %1").arg(Logs::mb(result.data(), unpacked).str()));
+		return mtpBuffer();
+	}
+	result.resize(unpacked / sizeof(mtpPrime));
+	if (result.isEmpty()) {
+		LOG(("RPC Error: bad length of unpacked data 0"));
+	}
+	return result;
+}
+
 SessionPrivate::SessionPrivate(
 	not_null<Instance*> instance,
 	not_null<QThread*> thread,
@@ -481,7 +615,7 @@ mtpMsgId SessionPrivate::replaceMsgId(SerializedRequest &request, mtpMsgId newId
 
 	while (_resendingIds.contains(newId)
 		|| _ackedIds.contains(newId)
-		|| haveSent.contains(newId)) {
+		|| haveSent.find(newId) != end(haveSent)) {
 		newId = base::unixtime::mtproto_msg_id();
 	}
 
@@ -1111,7 +1245,7 @@ void SessionPrivate::onSentSome(uint64 size) {
 			}
 		}
 		if (isUploadDcId(_shiftedDcId)) {
-			remain *= kUploadSessionsCount;
+			remain *= kUploadReceiveTimeoutMultiplier;
 		}
 		_waitForReceivedTimer.callOnce(remain);
 	}
@@ -1854,13 +1988,12 @@ SessionPrivate::HandleResult SessionPrivate::handleOneReceived(
 			const auto &haveSent = _sessionData->haveSentMap();
 			toResend.reserve(haveSent.size());
 			for (const auto &[msgId, request] : haveSent) {
-				if (msgId >= firstMsgId) {
-					break;
-				} else if (request->requestId) {
+				if (msgId < firstMsgId && request->requestId) {
 					toResend.push_back(msgId);
 				}
 			}
 		}
+		ranges::sort(toResend);
 		for (const auto msgId : toResend) {
 			resend(msgId, 10, true);
 		}
@@ -1962,56 +2095,16 @@ SessionPrivate::HandleResult SessionPrivate::handleBindResponse(
 	Unexpected("Result of BoundKeyCreator::handleBindResponse.");
 }
 
-mtpBuffer SessionPrivate::ungzip(const mtpPrime *from, const mtpPrime *end) const {
-	mtpBuffer result; // * 4 because of mtpPrime type
-	result.resize(0);
-
-	MTPstring packed;
-	if (!packed.read(from, end)) { // read packed string as serialized mtp string type
+mtpBuffer SessionPrivate::ungzip(const mtpPrime *from, const mtpPrime *end) {
+	const auto packed = ReadSerializedBytes(from, end);
+	if (packed.empty()) {
 		LOG(("RPC Error: could not read gziped bytes."));
-		return result;
-	}
-	uint32 packedLen = packed.v.size(), unpackedChunk = packedLen, unpackedLen = 0;
-
-	z_stream stream;
-	stream.zalloc = 0;
-	stream.zfree = 0;
-	stream.opaque = 0;
-	stream.avail_in = 0;
-	stream.next_in = 0;
-	int res = inflateInit2(&stream, 16 + MAX_WBITS);
-	if (res != Z_OK) {
-		LOG(("RPC Error: could not init zlib stream, code: %1").arg(res));
-		return result;
-	}
-	stream.avail_in = packedLen;
-	stream.next_in = reinterpret_cast<Bytef*>(packed.v.data());
-
-	stream.avail_out = 0;
-	while (!stream.avail_out) {
-		result.resize(result.size() + unpackedChunk);
-		stream.avail_out = unpackedChunk * sizeof(mtpPrime);
-		stream.next_out = (Bytef*)&result[result.size() - unpackedChunk];
-		int res = inflate(&stream, Z_NO_FLUSH);
-		if (res != Z_OK && res != Z_STREAM_END) {
-			inflateEnd(&stream);
-			LOG(("RPC Error: could not unpack gziped data, code: %1").arg(res));
-			DEBUG_LOG(("RPC Error: bad gzip: %1").arg(Logs::mb(packed.v.constData(), packedLen).str()));
-			return mtpBuffer();
-		}
-	}
-	if (stream.avail_out & 0x03) {
-		uint32 badSize = result.size() * sizeof(mtpPrime) - stream.avail_out;
-		LOG(("RPC Error: bad length of unpacked data %1").arg(badSize));
-		DEBUG_LOG(("RPC Error: bad unpacked data %1").arg(Logs::mb(result.data(), badSize).str()));
 		return mtpBuffer();
 	}
-	result.resize(result.size() - (stream.avail_out >> 2));
-	inflateEnd(&stream);
-	if (!result.size()) {
-		LOG(("RPC Error: bad length of unpacked data 0"));
+	if (!_inflater) {
+		_inflater = std::make_unique<Inflater>();
 	}
-	return result;
+	return _inflater->inflate(packed);
 }
 
 bool SessionPrivate::requestsFixTimeSalt(const QVector<MTPlong> &ids, const OuterInfo &info) {
@@ -2158,7 +2251,8 @@ void SessionPrivate::handleMsgsStates(const QVector<MTPlong> &ids, const QByteAr
 		const auto requestMsgId = ids[i].v;
 		{
 			QReadLocker locker(_sessionData->haveSentMutex());
-			if (!_sessionData->haveSentMap().contains(requestMsgId)) {
+			const auto &haveSent = _sessionData->haveSentMap();
+			if (haveSent.find(requestMsgId) == end(haveSent)) {
 				DEBUG_LOG(("Message Info: state was received for msgId %1, but request is not found, looking in resent requests...").arg(requestMsgId));
 				const auto reqIt = _resendingIds.find(requestMsgId);
 				if (reqIt != _resendingIds.cend()) {
@@ -54,6 +54,8 @@ public:
 private:
 	static constexpr auto kUpdateStateAlways = 666;
 
+	class Inflater;
+
 	struct TestConnection {
 		ConnectionPointer data;
 		int priority = 0;
@@ -134,7 +136,7 @@ private:
 	[[nodiscard]] HandleResult handleBindResponse(
 		mtpMsgId requestMsgId,
 		const mtpBuffer &response);
-	mtpBuffer ungzip(const mtpPrime *from, const mtpPrime *end) const;
+	mtpBuffer ungzip(const mtpPrime *from, const mtpPrime *end);
 	void handleMsgsStates(const QVector<MTPlong> &ids, const QByteArray &states);
 
 	// _sessionDataMutex must be locked for read.
@@ -239,6 +241,7 @@ private:
 	base::flat_map<mtpMsgId, SentContainer> _sentContainers;
 
 	std::unique_ptr<BoundKeyCreator> _keyCreator;
+	std::unique_ptr<Inflater> _inflater;
 	mtpMsgId _bindMsgId = 0;
 	crl::time _bindMessageSent = 0;
 
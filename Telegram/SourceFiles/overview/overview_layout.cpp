@@ -52,6 +52,10 @@ namespace {
 
 using TextState = HistoryView::TextState;
 
+// Sources up to this size (inline and small thumbnails) are prepared right
+// away, they serve as a placeholder while a large one is prepared async.
+constexpr auto kSyncPreparePixels = 160 * 160;
+
 TextParseOptions _documentNameOptions = {
 	TextParseMultiline | TextParseRichText | TextParseLinks | TextParseMarkdown, // flags
 	0, // maxw
@@ -59,6 +63,22 @@ TextParseOptions _documentNameOptions = {
 	Qt::LayoutDirectionAuto, // dir
 };
 
+[[nodiscard]] QImage PrepareSquare(QImage image, int size, bool blur) {
+	if (blur) {
+		image = Images::prepareBlur(std::move(image));
+	}
+	if (image.width() == image.height()) {
+		if (image.width() != size) {
+			image = image.scaled(size, size, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
+		}
+	} else if (image.width() > image.height()) {
+		image = image.copy((image.width() - image.height()) / 2, 0, image.height(), image.height()).scaled(size, size, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
+	} else {
+		image = image.copy(0, (image.height() - image.width()) / 2, image.width(), image.width()).scaled(size, size, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
+	}
+	return image;
+}
+
 } // namespace
 
 class Checkbox {
@@ -308,14 +328,15 @@ int32 Photo::resizeGetHeight(int32 width) {
 
 void Photo::paint(Painter &p, const QRect &clip, TextSelection selection, const PaintContext *context) {
 	const auto selected = (selection == FullSelection);
-	const auto widthChanged = _pix.width() != _width * cIntRetinaFactor();
+	const auto widthChanged = (_pixSize != _width * cIntRetinaFactor());
 	if (!_goodLoaded || widthChanged) {
 		ensureDataMediaCreated();
 		const auto good = _dataMedia->loaded()
 			|| (_dataMedia->image(Data::PhotoSize::Thumbnail) != nullptr);
 		if ((good && !_goodLoaded) || widthChanged) {
+			// Keep the current _pix until the new one is prepared,
+			// it is stretched to the new size in the meantime.
 			_goodLoaded = good;
-			_pix = QPixmap();
 			if (_goodLoaded) {
 				setPixFrom(_dataMedia->image(Data::PhotoSize::Large)
 					? _dataMedia->image(Data::PhotoSize::Large)
@@ -331,6 +352,10 @@ void Photo::paint(Painter &p, const QRect &clip, TextSelection selection, const
 
 	if (_pix.isNull()) {
 		p.fillRect(0, 0, _width, _height, st::overviewPhotoBg);
+	} else if (_pix.width() != _width * cIntRetinaFactor()) {
+		// The good one is still being prepared, stretch what we have.
+		auto hq = PainterHighQualityEnabler(p);
+		p.drawPixmap(QRect(0, 0, _width, _height), _pix);
 	} else {
 		p.drawPixmap(0, 0, _pix);
 	}
@@ -346,20 +371,10 @@ void Photo::paint(Painter &p, const QRect &clip, TextSelection selection, const
 
 void Photo::setPixFrom(not_null<Image*> image) {
 	const auto size = _width * cIntRetinaFactor();
-	auto img = image->original();
-	if (!_goodLoaded) {
-		img = Images::prepareBlur(std::move(img));
-	}
-	if (img.width() == img.height()) {
-		if (img.width() != size) {
-			img = img.scaled(size, size, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
-		}
-	} else if (img.width() > img.height()) {
-		img = img.copy((img.width() - img.height()) / 2, 0, img.height(), img.height()).scaled(size, size, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
-	} else {
-		img = img.copy(0, (img.height() - img.width()) / 2, img.width(), img.width()).scaled(size, size, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
-	}
-	img.setDevicePixelRatio(cRetinaFactor());
+	const auto blur = !_goodLoaded;
+	auto original = image->original();
+	_pixSize = size;
+	const auto requestId = ++_pixRequestId;
 
 	// In case we have inline thumbnail we can unload all images and we still
 	// won't get a blank image in the media viewer when the photo is opened.
@@ -368,7 +383,37 @@ void Photo::setPixFrom(not_null<Image*> image) {
 		delegate()->unregisterHeavyItem(this);
 	}
 
-	_pix = App::pixmapFromImageInPlace(std::move(img));
+	if (original.width() * original.height() <= kSyncPreparePixels) {
+		pixPrepared(PrepareSquare(std::move(original), size, blur));
+		return;
+	} else if (_pix.isNull()) {
+		const auto bytes = _data->inlineThumbnailBytes();
+		if (!bytes.isEmpty()) {
+			// Decoding the inline thumbnail is cheap, use it as placeholder.
+			auto placeholder = Images::FromInlineBytes(bytes);
+			if (!placeholder.isNull()) {
+				pixPrepared(PrepareSquare(std::move(placeholder), size, true));
+			}
+		}
+	}
+
+	// Only painted (visible) items get here, so the worker queue holds
+	// requests for visible rows, stale results are dropped by request id.
+	crl::async([=, weak = base::make_weak(this), image = std::move(original)]() mutable {
+		auto result = PrepareSquare(std::move(image), size, blur);
+		crl::on_main(weak, [=, result = std::move(result)]() mutable {
+			if (_pixRequestId == requestId) {
+				pixPrepared(std::move(result));
+				parent()->history()->session().data().requestItemRepaint(
+					parent());
+			}
+		});
+	});
+}
+
+void Photo::pixPrepared(QImage &&image) {
+	image.setDevicePixelRatio(cRetinaFactor());
+	_pix = App::pixmapFromImageInPlace(std::move(image));
 }
 
 void Photo::ensureDataMediaCreated() const {
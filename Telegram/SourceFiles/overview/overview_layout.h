@@ -192,12 +192,15 @@ public:
 private:
 	void ensureDataMediaCreated() const;
 	void setPixFrom(not_null<Image*> image);
+	void pixPrepared(QImage &&image);
 
 	const not_null<PhotoData*> _data;
 	mutable std::shared_ptr<Data::PhotoMedia> _dataMedia;
 	ClickHandlerPtr _link;
 
 	QPixmap _pix;
+	int _pixSize = 0;
+	int _pixRequestId = 0;
 	bool _goodLoaded = false;
 
 };
@@ -12,6 +12,9 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "mainwidget.h"
 #include "mainwindow.h"
 #include "data/data_session.h"
+#include "data/data_histories.h"
+#include "data/data_peer.h"
+#include "history/history.h"
 #include "main/main_session.h"
 #include "main/main_account.h"
 #include "main/main_domain.h"
@@ -73,6 +76,28 @@ auto GenerateCodes() {
 			window->session().updates().getDifference();
 		}
 	});
+	codes.emplace(qsl("loadedchats"), [](SessionController *window) {
+		if (!window) {
+			return;
+		}
+		constexpr auto kShowCount = 20;
+		const auto list = window->session().data().histories().loadedViews();
+		auto total = 0;
+		auto lines = QStringList();
+		for (const auto &entry : list) {
+			total += entry.count;
+			if (lines.size() < kShowCount) {
+				lines.push_back(entry.history->peer->name
+					+ qsl(": ")
+					+ QString::number(entry.count)
+					+ (entry.closed ? qsl(" (closed)") : QString()));
+			}
+		}
+		lines.push_front(qsl("Loaded messages: %1 in %2 chats.\n"
+			).arg(total
+			).arg(int(list.size())));
+		Ui::show(Box<InformBox>(lines.join('\n')));
+	});
 	codes.emplace(qsl("loadcolors"), [](SessionController *window) {
 		FileDialog::GetOpenPath(Core::App().getFileDialogParent(), "Open palette file", "Palette (*.tdesktop-palette)", [](const FileDialog::OpenResult &result) {
 			if (!result.paths.isEmpty()) {
@@ -20,6 +20,7 @@ namespace {
 constexpr auto kKillSessionTimeout = 15 * crl::time(1000);
 constexpr auto kStartWaitedInSession = 4 * kDownloadPartSize;
 constexpr auto kMaxWaitedInSession = 16 * kDownloadPartSize;
+constexpr auto kMaxWaitedInSessionLimit = 64 * kDownloadPartSize;
 constexpr auto kStartSessionsCount = 1;
 constexpr auto kMaxSessionsCount = 8;
 constexpr auto kMaxTrackedSessionRemoves = 64;
@@ -30,12 +31,22 @@ constexpr auto kMaxTrackedSuccesses = kRetryAddSessionSuccesses
 constexpr auto kRemoveSessionAfterTimeouts = 4;
 constexpr auto kResetDownloadPrioritiesTimeout = crl::time(200);
 constexpr auto kBadRequestDurationThreshold = 8 * crl::time(1000);
+constexpr auto kRateMeasureInterval = crl::time(500);
+constexpr auto kRateSmoothing = 0.25;
+constexpr auto kMinDurationLifetime = 10 * crl::time(1000);
+constexpr auto kWindowToBandwidthDelay = 2;
+constexpr auto kSessionAddMinGain = 1.1;
 
 // Each (session remove by timeouts) we wait for time:
 // kRetryAddSessionTimeout * max(removesCount, kMaxTrackedSessionRemoves)
 // and for successes in all remaining sessions:
 // kRetryAddSessionSuccesses * max(removesCount, kMaxTrackedSessionRemoves)
 
+// The waited amount in each session grows by one part for each request
+// that was sent with a full window, like TCP slow start, up to twice the
+// estimated bandwidth-delay product of the dc, and is halved when the
+// session times out. Sessions are added only while they add throughput.
+
 } // namespace
 
 void DownloadManagerMtproto::Queue::enqueue(
@@ -182,7 +193,7 @@ bool DownloadManagerMtproto::trySendNextPart(MTP::DcId dcId, Queue &queue) {
 		const auto proj = [](const DcSessionBalanceData &data) {
 			return (data.requested < data.maxWaitedAmount)
 				? data.requested
-				: kMaxWaitedInSession;
+				: kMaxWaitedInSessionLimit;
 		};
 		const auto j = ranges::min_element(sessions, ranges::less(), proj);
 		return (j->requested + kDownloadPartSize <= j->maxWaitedAmount)
@@ -208,6 +219,10 @@ int DownloadManagerMtproto::changeRequestedAmount(
 	Assert(i != _balanceData.end());
 	Assert(index < i->second.sessions.size());
 	const auto result = (i->second.sessions[index].requested += delta);
+	if (!i->second.totalRequested && delta > 0) {
+		i->second.rateMeasureStart = crl::now();
+		i->second.rateMeasureBytes = 0;
+	}
 	i->second.totalRequested += delta;
 	const auto findNonEmptySession = [](const DcBalanceData &data) {
 		using namespace rpl::mappers;
@@ -240,6 +255,7 @@ void DownloadManagerMtproto::requestSucceeded(
 		|| (amountAtRequestStart > data.maxWaitedAmount);
 	const auto parts = amountAtRequestStart / kDownloadPartSize;
 	const auto duration = (crl::now() - timeAtRequestStart);
+	updateEstimation(dc, overloaded ? 0 : duration);
 	DEBUG_LOG(("Download (%1,%2) request done, duration: %3, parts: %4%5"
 		).arg(dcId
 		).arg(index
@@ -257,11 +273,12 @@ void DownloadManagerMtproto::requestSucceeded(
 		});
 		return;
 	}
+	const auto maxWaited = maxWaitedInSession(dc);
 	if (amountAtRequestStart == data.maxWaitedAmount
-		&& data.maxWaitedAmount < kMaxWaitedInSession) {
+		&& data.maxWaitedAmount < maxWaited) {
 		data.maxWaitedAmount = std::min(
 			data.maxWaitedAmount + kDownloadPartSize,
-			kMaxWaitedInSession);
+			maxWaited);
 		DEBUG_LOG(("Download (%1,%2) increased max waited amount %3."
 			).arg(dcId
 			).arg(index
@@ -288,7 +305,10 @@ void DownloadManagerMtproto::requestSucceeded(
 	const auto delay = (dc.sessionRemoveTimes + 1) * kRetryAddSessionTimeout;
 	if (dc.lastSessionRemove && now < dc.lastSessionRemove + delay) {
 		return;
+	} else if (!sessionAddHelped(dc)) {
+		return;
 	}
+	dc.bytesPerMsOnSessionAdd = dc.bytesPerMs;
 	dc.sessions.emplace_back();
 	DEBUG_LOG(("Download (%1,%2) adding, now sessions: %3"
 		).arg(dcId
@@ -296,6 +316,51 @@ void DownloadManagerMtproto::requestSucceeded(
 		).arg(dc.sessions.size()));
 }
 
+void DownloadManagerMtproto::updateEstimation(
+		DcBalanceData &dc,
+		crl::time duration) {
+	const auto now = crl::now();
+	const auto elapsed = now - dc.rateMeasureStart;
+	dc.rateMeasureBytes += kDownloadPartSize;
+	if (dc.rateMeasureStart && elapsed >= kRateMeasureInterval) {
+		const auto rate = dc.rateMeasureBytes / float64(elapsed);
+		dc.bytesPerMs = (dc.bytesPerMs > 0.)
+			? (dc.bytesPerMs * (1. - kRateSmoothing) + rate * kRateSmoothing)
+			: rate;
+		dc.rateMeasureStart = now;
+		dc.rateMeasureBytes = 0;
+	}
+	if (duration > 0
+		&& (!dc.minDuration
+			|| duration <= dc.minDuration
+			|| now - dc.minDurationWhen >= kMinDurationLifetime)) {
+		dc.minDuration = duration;
+		dc.minDurationWhen = now;
+	}
+}
+
+int DownloadManagerMtproto::maxWaitedInSession(
+		const DcBalanceData &dc) const {
+	if (dc.bytesPerMs <= 0. || !dc.minDuration) {
+		return kMaxWaitedInSession;
+	}
+	const auto bandwidthDelay = dc.bytesPerMs * dc.minDuration;
+	const auto perSession = kWindowToBandwidthDelay
+		* bandwidthDelay
+		/ dc.sessions.size();
+	const auto parts = int(perSession / kDownloadPartSize) + 1;
+	return std::clamp(
+		parts * kDownloadPartSize,
+		kMaxWaitedInSession,
+		kMaxWaitedInSessionLimit);
+}
+
+bool DownloadManagerMtproto::sessionAddHelped(const DcBalanceData &dc) const {
+	return (dc.sessions.size() <= kStartSessionsCount)
+		|| (dc.bytesPerMsOnSessionAdd <= 0.)
+		|| (dc.bytesPerMs >= dc.bytesPerMsOnSessionAdd * kSessionAddMinGain);
+}
+
 int DownloadManagerMtproto::chooseSessionIndex(MTP::DcId dcId) const {
 	const auto i = _balanceData.find(dcId);
 	Assert(i != end(_balanceData));
@@ -320,6 +385,11 @@ void DownloadManagerMtproto::sessionTimedOut(MTP::DcId dcId, int index) {
 	for (auto &session : dc.sessions) {
 		session.successes = 0;
 	}
+	auto &timedOut = dc.sessions[index];
+	timedOut.maxWaitedAmount = std::max(
+		(timedOut.maxWaitedAmount / (2 * kDownloadPartSize))
+			* kDownloadPartSize,
+		kStartWaitedInSession);
 	if (dc.sessions.size() == kStartSessionsCount
 		|| ++dc.timeouts < kRemoveSessionAfterTimeouts) {
 		return;
@@ -348,11 +418,12 @@ void DownloadManagerMtproto::removeSession(MTP::DcId dcId) {
 	auto &session = dc.sessions.back();
 
 	// Make sure we don't send anything to that session while redirecting.
-	session.requested += kMaxWaitedInSession * kMaxSessionsCount;
+	session.requested += kMaxWaitedInSessionLimit * kMaxSessionsCount;
 	queue.removeSession(index);
-	Assert(session.requested == kMaxWaitedInSession * kMaxSessionsCount);
+	Assert(session.requested == kMaxWaitedInSessionLimit * kMaxSessionsCount);
 
 	dc.sessions.pop_back();
+	dc.bytesPerMsOnSessionAdd = 0.;
 	api().instance().killSession(MTP::downloadDcId(dcId, index));
 
 	dc.lastSessionRemove = crl::now();
@@ -669,19 +740,18 @@ void DownloadMtprotoTask::cdnPartLoaded(const MTPupload_CdnFile &result, mtpRequ
 		Expects(key.size() == MTP::CTRState::KeySize);
 		Expects(iv.size() == MTP::CTRState::IvecSize);
 
-		auto state = MTP::CTRState();
-		auto ivec = bytes::make_span(state.ivec);
-		std::copy(iv.begin(), iv.end(), ivec.begin());
+		auto ivec = bytes::array<MTP::CTRState::IvecSize>();
+		bytes::copy(ivec, iv);
 
 		auto counterOffset = static_cast<uint32>(requestData.offset) >> 4;
-		state.ivec[15] = static_cast<uchar>(counterOffset & 0xFF);
-		state.ivec[14] = static_cast<uchar>((counterOffset >> 8) & 0xFF);
-		state.ivec[13] = static_cast<uchar>((counterOffset >> 16) & 0xFF);
-		state.ivec[12] = static_cast<uchar>((counterOffset >> 24) & 0xFF);
+		ivec[15] = static_cast<bytes::type>(counterOffset & 0xFF);
+		ivec[14] = static_cast<bytes::type>((counterOffset >> 8) & 0xFF);
+		ivec[13] = static_cast<bytes::type>((counterOffset >> 16) & 0xFF);
+		ivec[12] = static_cast<bytes::type>((counterOffset >> 24) & 0xFF);
 
 		auto decryptInPlace = data.vbytes().v;
 		auto buffer = bytes::make_detached_span(decryptInPlace);
-		MTP::aesCtrEncrypt(buffer, key.data(), &state);
+		MTP::CTRStream(key, ivec).encrypt(buffer);
 
 		switch (checkCdnFileHash(requestData.offset, buffer)) {
 		case CheckCdnHashResult::NoHash: {
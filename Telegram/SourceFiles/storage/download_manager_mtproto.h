@@ -91,8 +91,20 @@ private:
 		int sessionRemoveTimes = 0;
 		int timeouts = 0; // Since all sessions had successes >= required.
 		int totalRequested = 0;
+
+		// Delivery rate and round trip estimations for the window sizes.
+		crl::time rateMeasureStart = 0;
+		int64 rateMeasureBytes = 0;
+		float64 bytesPerMs = 0.;
+		crl::time minDuration = 0;
+		crl::time minDurationWhen = 0;
+		float64 bytesPerMsOnSessionAdd = 0.;
 	};
 
+	void updateEstimation(DcBalanceData &dc, crl::time duration);
+	[[nodiscard]] int maxWaitedInSession(const DcBalanceData &dc) const;
+	[[nodiscard]] bool sessionAddHelped(const DcBalanceData &dc) const;
+
 	void checkSendNext();
 	void checkSendNext(MTP::DcId dcId, Queue &queue);
 	bool trySendNextPart(MTP::DcId dcId, Queue &queue);
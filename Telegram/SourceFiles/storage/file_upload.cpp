@@ -27,7 +27,11 @@ namespace Storage {
 namespace {
 
 // max 512kb uploaded at the same time in each session
-constexpr auto kMaxUploadFileParallelSize = MTP::kUploadSessionsCount * 512 * 1024;
+constexpr auto kUploadSessionWindow = 512 * 1024;
+constexpr auto kStartSessionsCount = 2;
+
+// Parts of that many first files in the queue are sent in turns.
+constexpr auto kMaxUploadingFiles = 4;
 
 constexpr auto kDocumentMaxPartsCount = 3000;
 
@@ -46,18 +50,55 @@ constexpr auto kDocumentUploadPartSize3 = 256 * 1024;
 // 512kb for large document ( <= 1500mb )
 constexpr auto kDocumentUploadPartSize4 = 512 * 1024;
 
-// One part each half second, if not uploaded faster.
-constexpr auto kUploadRequestInterval = crl::time(500);
-
 // How much time without upload causes additional session kill.
-constexpr auto kKillSessionTimeout = 15 * crl::time(000);
+constexpr auto kKillSessionTimeout = 15 * crl::time(1000);
+
+// Sessions are added while they make the upload faster.
+constexpr auto kRateMeasureInterval = crl::time(1000);
+constexpr auto kRateSmoothing = 0.5;
+constexpr auto kSessionAddMinGain = 1.1;
+
+// How many document parts we read from disk ahead of sending them.
+constexpr auto kDocumentReadAheadParts = 4;
 
 [[nodiscard]] const char *ThumbnailFormat(const QString &mime) {
 	return Core::IsMimeSticker(mime) ? "WEBP" : "JPG";
 }
 
+[[nodiscard]] QByteArray ReadDocumentPart(
+		QFile &file,
+		int64 offset,
+		int size) {
+	if (!file.isOpen() && !file.open(QIODevice::ReadOnly)) {
+		return QByteArray();
+	}
+	const auto available = std::min(int64(size), file.size() - offset);
+	if (available <= 0) {
+		return QByteArray();
+	} else if (const auto mapped = file.map(offset, available)) {
+		auto result = QByteArray(
+			reinterpret_cast<const char*>(mapped),
+			available);
+		file.unmap(mapped);
+		return result;
+	} else if (!file.seek(offset)) {
+		return QByteArray();
+	}
+	return file.read(available);
+}
+
 } // namespace
 
+// Parts are read and hashed by one background task at a time,
+// so the file and the hash are never accessed concurrently.
+struct Uploader::DocumentReader {
+	explicit DocumentReader(const QString &path) : file(path) {
+	}
+
+	QFile file;
+	HashMd5 md5;
+};
+
 struct Uploader::File {
 	File(const SendMediaReady &media);
 	File(const std::shared_ptr<FileLoadResult> &file);
@@ -71,18 +112,30 @@ struct Uploader::File {
 	mutable int32 fileSentSize = 0;
 
 	uint64 id() const;
+	PeerId peer() const;
 	SendMediaType type() const;
 	uint64 thumbId() const;
 	const QString &filename() const;
 
+	// Photo or thumbnail parts, prepared in memory.
+	UploadFileParts &memoryParts();
+	uint64 memoryPartsId() const;
+
 	HashMd5 md5Hash;
 
-	std::unique_ptr<QFile> docFile;
+	std::shared_ptr<DocumentReader> docReader;
+	base::flat_map<int32, QByteArray> docReadParts;
+	int32 docReadRequested = 0;
+	bool docReading = false;
 	int32 docSentParts = 0;
 	int32 docSize = 0;
 	int32 docPartSize = 0;
 	int32 docPartsCount = 0;
 
+	int partsInFlight = 0;
+	int docPartsInFlight = 0;
+	bool started = false;
+
 };
 
 Uploader::File::File(const SendMediaReady &media) : media(media) {
@@ -140,6 +193,10 @@ uint64 Uploader::File::id() const {
 	return file ? file->id : media.id;
 }
 
+PeerId Uploader::File::peer() const {
+	return file ? file->to.peer : media.peer;
+}
+
 SendMediaType Uploader::File::type() const {
 	return file ? file->type : media.type;
 }
@@ -152,9 +209,27 @@ const QString &Uploader::File::filename() const {
 	return file ? file->filename : media.filename;
 }
 
+UploadFileParts &Uploader::File::memoryParts() {
+	return file
+		? ((type() == SendMediaType::Photo
+			|| type() == SendMediaType::Secure)
+			? file->fileparts
+			: file->thumbparts)
+		: media.parts;
+}
+
+uint64 Uploader::File::memoryPartsId() const {
+	return file
+		? ((type() == SendMediaType::Photo
+			|| type() == SendMediaType::Secure)
+			? file->id
+			: file->thumbId)
+		: media.thumbId;
+}
+
 Uploader::Uploader(not_null<ApiWrap*> api)
 : _api(api)
-, _nextTimer([=] { sendNext(); })
+, _sessionsCount(kStartSessionsCount)
 , _stopSessionsTimer([=] { stopSessions(); }) {
 	const auto session = &_api->session();
 	photoReady(
@@ -376,37 +451,41 @@ void Uploader::upload(
 	sendNext();
 }
 
-void Uploader::currentFailed() {
-	auto j = queue.find(uploadingId);
-	if (j != queue.end()) {
-		if (j->second.type() == SendMediaType::Photo) {
-			_photoFailed.fire_copy(j->first);
-		} else if (j->second.type() == SendMediaType::File
-			|| j->second.type() == SendMediaType::ThemeFile
-			|| j->second.type() == SendMediaType::Audio) {
-			const auto document = session().data().document(j->second.id());
-			if (document->uploading()) {
-				document->status = FileUploadFailed;
-			}
-			_documentFailed.fire_copy(j->first);
-		} else if (j->second.type() == SendMediaType::Secure) {
-			_secureFailed.fire_copy(j->first);
-		} else {
-			Unexpected("Type in Uploader::currentFailed.");
+void Uploader::failed(const FullMsgId &msgId) {
+	const auto j = queue.find(msgId);
+	if (j == queue.end()) {
+		return;
+	}
+	if (j->second.type() == SendMediaType::Photo) {
+		_photoFailed.fire_copy(j->first);
+	} else if (j->second.type() == SendMediaType::File
+		|| j->second.type() == SendMediaType::ThemeFile
+		|| j->second.type() == SendMediaType::Audio) {
+		const auto document = session().data().document(j->second.id());
+		if (document->uploading()) {
+			document->status = FileUploadFailed;
 		}
-		queue.erase(j);
+		_documentFailed.fire_copy(j->first);
+	} else if (j->second.type() == SendMediaType::Secure) {
+		_secureFailed.fire_copy(j->first);
+	} else {
+		Unexpected("Type in Uploader::failed.");
 	}
+	cancelRequests(msgId);
+	queue.erase(msgId);
+}
 
-	requestsSent.clear();
-	docRequestsSent.clear();
-	dcMap.clear();
-	uploadingId = FullMsgId();
-	sentSize = 0;
-	for (int i = 0; i < MTP::kUploadSessionsCount; ++i) {
-		sentSizes[i] = 0;
+void Uploader::cancelRequests(const FullMsgId &msgId) {
+	for (auto i = begin(requestsSent); i != end(requestsSent);) {
+		if (i->second.fullId == msgId) {
+			_api->request(i->first).cancel();
+			sentSize -= i->second.size;
+			sentSizes[i->second.dc] -= i->second.size;
+			i = requestsSent.erase(i);
+		} else {
+			++i;
+		}
 	}
-
-	sendNext();
 }
 
 void Uploader::stopSessions() {
@@ -415,10 +494,15 @@ void Uploader::stopSessions() {
 	}
 }
 
+uint32 Uploader::maxSentSize() const {
+	return uint32(_sessionsCount * kUploadSessionWindow);
+}
+
 void Uploader::sendNext() {
-	if (sentSize >= kMaxUploadFileParallelSize || _pausedId.msg) {
+	if (_pausedId.msg) {
 		return;
 	}
+	finishUploaded();
 
 	const auto stopping = _stopSessionsTimer.isActive();
 	if (queue.empty()) {
@@ -431,183 +515,157 @@ void Uploader::sendNext() {
 	if (stopping) {
 		_stopSessionsTimer.cancel();
 	}
-	auto i = uploadingId.msg ? queue.find(uploadingId) : queue.begin();
-	if (!uploadingId.msg) {
-		uploadingId = i->first;
-	} else if (i == queue.end()) {
-		i = queue.begin();
-		uploadingId = i->first;
+	while (sentSize < maxSentSize()) {
+		if (!sendNextPart()) {
+			return;
+		}
+	}
+	_windowFilled = true;
+}
+
+void Uploader::finishUploaded() {
+	// Ready files are reported in the queue order inside one chat, so that
+	// messages there are sent in the same order they were added to the queue.
+	// Files for other chats don't wait for them.
+	auto waiting = base::flat_set<PeerId>();
+	auto ready = std::vector<FullMsgId>();
+	for (auto &[fullId, file] : queue) {
+		const auto peer = file.peer();
+		if (waiting.contains(peer)) {
+			continue;
+		} else if (file.partsInFlight > 0
+			|| !file.memoryParts().isEmpty()
+			|| file.docSentParts < file.docPartsCount) {
+			waiting.emplace(peer);
+		} else {
+			ready.push_back(fullId);
+		}
+	}
+	for (const auto &fullId : ready) {
+		const auto i = queue.find(fullId);
+		if (i != end(queue)) {
+			fileUploaded(fullId, i->second);
+			queue.erase(fullId);
+		}
+	}
+}
+
+bool Uploader::sendNextPart() {
+	// Several first files of the queue take turns in sending parts,
+	// so that small files are not waiting behind a large one.
+	auto candidates = std::vector<FullMsgId>();
+	candidates.reserve(kMaxUploadingFiles);
+	for (auto &[fullId, file] : queue) {
+		if (file.memoryParts().isEmpty()
+			&& file.docSentParts >= file.docPartsCount) {
+			continue;
+		}
+		candidates.push_back(fullId);
+		if (int(candidates.size()) == kMaxUploadingFiles) {
+			break;
+		}
 	}
-	auto &uploadingData = i->second;
+	const auto from = ranges::upper_bound(candidates, _lastPartOf);
+	std::rotate(begin(candidates), from, end(candidates));
 
 	auto todc = 0;
-	for (auto dc = 1; dc != MTP::kUploadSessionsCount; ++dc) {
+	for (auto dc = 1; dc != _sessionsCount; ++dc) {
 		if (sentSizes[dc] < sentSizes[todc]) {
 			todc = dc;
 		}
 	}
-
-	auto &parts = uploadingData.file
-		? ((uploadingData.type() == SendMediaType::Photo
-			|| uploadingData.type() == SendMediaType::Secure)
-			? uploadingData.file->fileparts
-			: uploadingData.file->thumbparts)
-		: uploadingData.media.parts;
-	const auto partsOfId = uploadingData.file
-		? ((uploadingData.type() == SendMediaType::Photo
-			|| uploadingData.type() == SendMediaType::Secure)
-			? uploadingData.file->id
-			: uploadingData.file->thumbId)
-		: uploadingData.media.thumbId;
-	if (parts.isEmpty()) {
-		if (uploadingData.docSentParts >= uploadingData.docPartsCount) {
-			if (requestsSent.empty() && docRequestsSent.empty()) {
-				const auto options = uploadingData.file
-					? uploadingData.file->to.options
-					: Api::SendOptions();
-				const auto edit = uploadingData.file &&
-					uploadingData.file->to.replaceMediaOf;
-				if (uploadingData.type() == SendMediaType::Photo) {
-					auto photoFilename = uploadingData.filename();
-					if (!photoFilename.endsWith(qstr(".jpg"), Qt::CaseInsensitive)) {
-						// Server has some extensions checking for inputMediaUploadedPhoto,
-						// so force the extension to be .jpg anyway. It doesn't matter,
-						// because the filename from inputFile is not used anywhere.
-						photoFilename += qstr(".jpg");
-					}
-					const auto md5 = uploadingData.file
-						? uploadingData.file->filemd5
-						: uploadingData.media.jpeg_md5;
-					const auto file = MTP_inputFile(
-						MTP_long(uploadingData.id()),
-						MTP_int(uploadingData.partsCount),
-						MTP_string(photoFilename),
-						MTP_bytes(md5));
-					_photoReady.fire({ uploadingId, options, file, edit });
-				} else if (uploadingData.type() == SendMediaType::File
-					|| uploadingData.type() == SendMediaType::ThemeFile
-					|| uploadingData.type() == SendMediaType::Audio) {
-					QByteArray docMd5(32, Qt::Uninitialized);
-					hashMd5Hex(uploadingData.md5Hash.result(), docMd5.data());
-
-					const auto file = (uploadingData.docSize > kUseBigFilesFrom)
-						? MTP_inputFileBig(
-							MTP_long(uploadingData.id()),
-							MTP_int(uploadingData.docPartsCount),
-							MTP_string(uploadingData.filename()))
-						: MTP_inputFile(
-							MTP_long(uploadingData.id()),
-							MTP_int(uploadingData.docPartsCount),
-							MTP_string(uploadingData.filename()),
-							MTP_bytes(docMd5));
-					if (uploadingData.partsCount) {
-						const auto thumbFilename = uploadingData.file
-							? uploadingData.file->thumbname
-							: (qsl("thumb.") + uploadingData.media.thumbExt);
-						const auto thumbMd5 = uploadingData.file
-							? uploadingData.file->thumbmd5
-							: uploadingData.media.jpeg_md5;
-						const auto thumb = MTP_inputFile(
-							MTP_long(uploadingData.thumbId()),
-							MTP_int(uploadingData.partsCount),
-							MTP_string(thumbFilename),
-							MTP_bytes(thumbMd5));
-						_thumbDocumentReady.fire({
-							uploadingId,
-							options,
-							file,
-							thumb,
-							edit });
-					} else {
-						_documentReady.fire({
-							uploadingId,
-							options,
-							file,
-							edit });
-					}
-				} else if (uploadingData.type() == SendMediaType::Secure) {
-					_secureReady.fire({
-						uploadingId,
-						uploadingData.id(),
-						uploadingData.partsCount });
-				}
-				queue.erase(uploadingId);
-				uploadingId = FullMsgId();
-				sendNext();
-			}
-			return;
+	for (const auto &fullId : candidates) {
+		const auto i = queue.find(fullId);
+		if (i != end(queue) && sendPart(fullId, i->second, todc)) {
+			_lastPartOf = fullId;
+			return true;
 		}
+	}
+	return false;
+}
 
-		auto &content = uploadingData.file
-			? uploadingData.file->content
-			: uploadingData.media.data;
-		QByteArray toSend;
-		if (content.isEmpty()) {
-			if (!uploadingData.docFile) {
-				const auto filepath = uploadingData.file
-					? uploadingData.file->filepath
-					: uploadingData.media.file;
-				uploadingData.docFile = std::make_unique<QFile>(filepath);
-				if (!uploadingData.docFile->open(QIODevice::ReadOnly)) {
-					currentFailed();
-					return;
-				}
-			}
-			toSend = uploadingData.docFile->read(uploadingData.docPartSize);
-			if (uploadingData.docSize <= kUseBigFilesFrom) {
-				uploadingData.md5Hash.feed(toSend.constData(), toSend.size());
-			}
-		} else {
-			const auto offset = uploadingData.docSentParts
-				* uploadingData.docPartSize;
-			toSend = content.mid(offset, uploadingData.docPartSize);
-			if ((uploadingData.type() == SendMediaType::File
-				|| uploadingData.type() == SendMediaType::ThemeFile
-				|| uploadingData.type() == SendMediaType::Audio)
-				&& uploadingData.docSentParts <= kUseBigFilesFrom) {
-				uploadingData.md5Hash.feed(toSend.constData(), toSend.size());
-			}
+void Uploader::fileUploaded(const FullMsgId &fullId, File &file) {
+	const auto options = file.file
+		? file.file->to.options
+		: Api::SendOptions();
+	const auto edit = file.file && file.file->to.replaceMediaOf;
+	if (file.type() == SendMediaType::Photo) {
+		auto photoFilename = file.filename();
+		if (!photoFilename.endsWith(qstr(".jpg"), Qt::CaseInsensitive)) {
+			// Server has some extensions checking for inputMediaUploadedPhoto,
+			// so force the extension to be .jpg anyway. It doesn't matter,
+			// because the filename from inputFile is not used anywhere.
+			photoFilename += qstr(".jpg");
 		}
-		if ((toSend.size() > uploadingData.docPartSize)
-			|| ((toSend.size() < uploadingData.docPartSize
-				&& uploadingData.docSentParts + 1 != uploadingData.docPartsCount))) {
-			currentFailed();
-			return;
-		}
-		mtpRequestId requestId;
-		if (uploadingData.docSize > kUseBigFilesFrom) {
-			requestId = _api->request(MTPupload_SaveBigFilePart(
-				MTP_long(uploadingData.id()),
-				MTP_int(uploadingData.docSentParts),
-				MTP_int(uploadingData.docPartsCount),
-				MTP_bytes(toSend)
-			)).done([=](const MTPBool &result, mtpRequestId requestId) {
-				partLoaded(result, requestId);
-			}).fail([=](const MTP::Error &error, mtpRequestId requestId) {
-				partFailed(error, requestId);
-			}).toDC(MTP::uploadDcId(todc)).send();
+		const auto md5 = file.file
+			? file.file->filemd5
+			: file.media.jpeg_md5;
+		const auto input = MTP_inputFile(
+			MTP_long(file.id()),
+			MTP_int(file.partsCount),
+			MTP_string(photoFilename),
+			MTP_bytes(md5));
+		_photoReady.fire({ fullId, options, input, edit });
+	} else if (file.type() == SendMediaType::File
+		|| file.type() == SendMediaType::ThemeFile
+		|| file.type() == SendMediaType::Audio) {
+		QByteArray docMd5(32, Qt::Uninitialized);
+		hashMd5Hex(
+			(file.docReader
+				? file.docReader->md5.result()
+				: file.md5Hash.result()),
+			docMd5.data());
+
+		const auto input = (file.docSize > kUseBigFilesFrom)
+			? MTP_inputFileBig(
+				MTP_long(file.id()),
+				MTP_int(file.docPartsCount),
+				MTP_string(file.filename()))
+			: MTP_inputFile(
+				MTP_long(file.id()),
+				MTP_int(file.docPartsCount),
+				MTP_string(file.filename()),
+				MTP_bytes(docMd5));
+		if (file.partsCount) {
+			const auto thumbFilename = file.file
+				? file.file->thumbname
+				: (qsl("thumb.") + file.media.thumbExt);
+			const auto thumbMd5 = file.file
+				? file.file->thumbmd5
+				: file.media.jpeg_md5;
+			const auto thumb = MTP_inputFile(
+				MTP_long(file.thumbId()),
+				MTP_int(file.partsCount),
+				MTP_string(thumbFilename),
+				MTP_bytes(thumbMd5));
+			_thumbDocumentReady.fire({
+				fullId,
+				options,
+				input,
+				thumb,
+				edit });
 		} else {
-			requestId = _api->request(MTPupload_SaveFilePart(
-				MTP_long(uploadingData.id()),
-				MTP_int(uploadingData.docSentParts),
-				MTP_bytes(toSend)
-			)).done([=](const MTPBool &result, mtpRequestId requestId) {
-				partLoaded(result, requestId);
-			}).fail([=](const MTP::Error &error, mtpRequestId requestId) {
-				partFailed(error, requestId);
-			}).toDC(MTP::uploadDcId(todc)).send();
+			_documentReady.fire({
+				fullId,
+				options,
+				input,
+				edit });
 		}
-		docRequestsSent.emplace(requestId, uploadingData.docSentParts);
-		dcMap.emplace(requestId, todc);
-		sentSize += uploadingData.docPartSize;
-		sentSizes[todc] += uploadingData.docPartSize;
-
-		uploadingData.docSentParts++;
-	} else {
-		auto part = parts.begin();
+	} else if (file.type() == SendMediaType::Secure) {
+		_secureReady.fire({
+			fullId,
+			file.id(),
+			file.partsCount });
+	}
+}
 
+bool Uploader::sendPart(const FullMsgId &fullId, File &file, int todc) {
+	auto &parts = file.memoryParts();
+	if (!parts.isEmpty()) {
+		const auto part = parts.begin();
+		const auto size = int32(part.value().size());
 		const auto requestId = _api->request(MTPupload_SaveFilePart(
-			MTP_long(partsOfId),
+			MTP_long(file.memoryPartsId()),
 			MTP_int(part.key()),
 			MTP_bytes(part.value())
 		)).done([=](const MTPBool &result, mtpRequestId requestId) {
@@ -615,23 +673,181 @@ void Uploader::sendNext() {
 		}).fail([=](const MTP::Error &error, mtpRequestId requestId) {
 			partFailed(error, requestId);
 		}).toDC(MTP::uploadDcId(todc)).send();
-		requestsSent.emplace(requestId, part.value());
-		dcMap.emplace(requestId, todc);
-		sentSize += part.value().size();
-		sentSizes[todc] += part.value().size();
-
+		partSent(requestId, fullId, file, size, todc, false);
 		parts.erase(part);
+		return true;
+	} else if (file.docSentParts >= file.docPartsCount) {
+		return false;
+	}
+
+	auto &content = file.file
+		? file.file->content
+		: file.media.data;
+	QByteArray toSend;
+	if (content.isEmpty()) {
+		if (!file.docReader) {
+			file.docReader = std::make_shared<DocumentReader>(
+				(file.file
+					? file.file->filepath
+					: file.media.file));
+		}
+		readDocumentParts(fullId, file);
+		const auto ready = file.docReadParts.find(file.docSentParts);
+		if (ready == end(file.docReadParts)) {
+			// sendNext() will be called when the part is read.
+			return false;
+		}
+		toSend = std::move(ready->second);
+		file.docReadParts.erase(ready);
+		readDocumentParts(fullId, file);
+	} else {
+		const auto offset = file.docSentParts * file.docPartSize;
+		toSend = content.mid(offset, file.docPartSize);
+		if ((file.type() == SendMediaType::File
+			|| file.type() == SendMediaType::ThemeFile
+			|| file.type() == SendMediaType::Audio)
+			&& file.docSentParts <= kUseBigFilesFrom) {
+			file.md5Hash.feed(toSend.constData(), toSend.size());
+		}
+	}
+	if (toSend.isEmpty()
+		|| (toSend.size() > file.docPartSize)
+		|| ((toSend.size() < file.docPartSize
+			&& file.docSentParts + 1 != file.docPartsCount))) {
+		failed(fullId);
+		return true;
+	}
+	mtpRequestId requestId;
+	if (file.docSize > kUseBigFilesFrom) {
+		requestId = _api->request(MTPupload_SaveBigFilePart(
+			MTP_long(file.id()),
+			MTP_int(file.docSentParts),
+			MTP_int(file.docPartsCount),
+			MTP_bytes(toSend)
+		)).done([=](const MTPBool &result, mtpRequestId requestId) {
+			partLoaded(result, requestId);
+		}).fail([=](const MTP::Error &error, mtpRequestId requestId) {
+			partFailed(error, requestId);
+		}).toDC(MTP::uploadDcId(todc)).send();
+	} else {
+		requestId = _api->request(MTPupload_SaveFilePart(
+			MTP_long(file.id()),
+			MTP_int(file.docSentParts),
+			MTP_bytes(toSend)
+		)).done([=](const MTPBool &result, mtpRequestId requestId) {
+			partLoaded(result, requestId);
+		}).fail([=](const MTP::Error &error, mtpRequestId requestId) {
+			partFailed(error, requestId);
+		}).toDC(MTP::uploadDcId(todc)).send();
+	}
+	partSent(requestId, fullId, file, file.docPartSize, todc, true);
+	++file.docSentParts;
+	return true;
+}
+
+void Uploader::partSent(
+		mtpRequestId requestId,
+		const FullMsgId &fullId,
+		File &file,
+		int32 size,
+		int dc,
+		bool document) {
+	if (requestsSent.empty()) {
+		_rateMeasureStart = crl::now();
+		_rateMeasureBytes = 0;
+	}
+	requestsSent.emplace(requestId, SentRequest{
+		.fullId = fullId,
+		.size = size,
+		.dc = dc,
+		.document = document,
+	});
+	sentSize += size;
+	sentSizes[dc] += size;
+	++file.partsInFlight;
+	file.started = true;
+	if (document) {
+		++file.docPartsInFlight;
 	}
-	_nextTimer.callOnce(kUploadRequestInterval);
+}
+
+void Uploader::measureUploaded(int32 size) {
+	const auto now = crl::now();
+	const auto elapsed = now - _rateMeasureStart;
+	_rateMeasureBytes += size;
+	if (!_rateMeasureStart || elapsed < kRateMeasureInterval) {
+		return;
+	}
+	const auto rate = _rateMeasureBytes / float64(elapsed);
+	_bytesPerMs = (_bytesPerMs > 0.)
+		? (_bytesPerMs * (1. - kRateSmoothing) + rate * kRateSmoothing)
+		: rate;
+	_rateMeasureStart = now;
+	_rateMeasureBytes = 0;
+
+	// Add a session only if the whole window was in use
+	// and the previous added session made the upload faster.
+	if (base::take(_windowFilled)
+		&& _sessionsCount < MTP::kUploadSessionsCount
+		&& _bytesPerMs >= _bytesPerMsOnSessionAdd * kSessionAddMinGain) {
+		_bytesPerMsOnSessionAdd = _bytesPerMs;
+		++_sessionsCount;
+		DEBUG_LOG(("Upload Info: now sessions %1.").arg(_sessionsCount));
+	}
+}
+
+void Uploader::readDocumentParts(const FullMsgId &msgId, File &file) {
+	Expects(file.docReader != nullptr);
+
+	if (file.docReading
+		|| file.docReadRequested >= file.docPartsCount
+		|| (file.docReadRequested - file.docSentParts
+			>= kDocumentReadAheadParts)) {
+		return;
+	}
+	file.docReading = true;
+	const auto index = file.docReadRequested++;
+	const auto offset = int64(index) * file.docPartSize;
+	const auto size = file.docPartSize;
+	const auto hash = (file.docSize <= kUseBigFilesFrom);
+	crl::async([=, reader = file.docReader] {
+		auto bytes = ReadDocumentPart(reader->file, offset, size);
+		if (hash) {
+			reader->md5.feed(bytes.constData(), bytes.size());
+		}
+		crl::on_main(this, [=, bytes = std::move(bytes)]() mutable {
+			documentPartRead(msgId, reader, index, std::move(bytes));
+		});
+	});
+}
+
+void Uploader::documentPartRead(
+		const FullMsgId &msgId,
+		const std::shared_ptr<DocumentReader> &reader,
+		int32 index,
+		QByteArray &&bytes) {
+	const auto i = queue.find(msgId);
+	if (i == end(queue) || i->second.docReader != reader) {
+		return;
+	}
+	auto &file = i->second;
+	file.docReading = false;
+	file.docReadParts.emplace(index, std::move(bytes));
+	readDocumentParts(msgId, file);
+	sendNext();
 }
 
 void Uploader::cancel(const FullMsgId &msgId) {
 	uploaded.erase(msgId);
-	if (uploadingId == msgId) {
-		currentFailed();
+	const auto i = queue.find(msgId);
+	if (i == end(queue)) {
+		return;
+	} else if (i->second.started) {
+		failed(msgId);
 	} else {
-		queue.erase(msgId);
+		queue.erase(i);
 	}
+	sendNext();
 }
 
 void Uploader::pause(const FullMsgId &msgId) {
@@ -653,89 +869,77 @@ void Uploader::clear() {
 		_api->request(requestData.first).cancel();
 	}
 	requestsSent.clear();
-	for (const auto &requestData : docRequestsSent) {
-		_api->request(requestData.first).cancel();
-	}
-	docRequestsSent.clear();
-	dcMap.clear();
 	sentSize = 0;
 	for (int i = 0; i < MTP::kUploadSessionsCount; ++i) {
 		_api->instance().stopSession(MTP::uploadDcId(i));
 		sentSizes[i] = 0;
 	}
+	_sessionsCount = kStartSessionsCount;
+	_bytesPerMs = _bytesPerMsOnSessionAdd = 0.;
+	_windowFilled = false;
 	_stopSessionsTimer.cancel();
 }
 
 void Uploader::partLoaded(const MTPBool &result, mtpRequestId requestId) {
-	auto j = docRequestsSent.end();
-	auto i = requestsSent.find(requestId);
-	if (i == requestsSent.cend()) {
-		j = docRequestsSent.find(requestId);
-	}
-	if (i != requestsSent.cend() || j != docRequestsSent.cend()) {
-		if (mtpIsFalse(result)) { // failed to upload current file
-			currentFailed();
-			return;
-		} else {
-			auto dcIt = dcMap.find(requestId);
-			if (dcIt == dcMap.cend()) { // must not happen
-				currentFailed();
-				return;
-			}
-			auto dc = dcIt->second;
-			dcMap.erase(dcIt);
-
-			int32 sentPartSize = 0;
-			auto k = queue.find(uploadingId);
-			Assert(k != queue.cend());
-			auto &[fullId, file] = *k;
-			if (i != requestsSent.cend()) {
-				sentPartSize = i->second.size();
-				requestsSent.erase(i);
-			} else {
-				sentPartSize = file.docPartSize;
-				docRequestsSent.erase(j);
-			}
-			sentSize -= sentPartSize;
-			sentSizes[dc] -= sentPartSize;
-			if (file.type() == SendMediaType::Photo) {
-				file.fileSentSize += sentPartSize;
-				const auto photo = session().data().photo(file.id());
-				if (photo->uploading() && file.file) {
-					photo->uploadingData->size = file.file->partssize;
-					photo->uploadingData->offset = file.fileSentSize;
-				}
-				_photoProgress.fire_copy(fullId);
-			} else if (file.type() == SendMediaType::File
-				|| file.type() == SendMediaType::ThemeFile
-				|| file.type() == SendMediaType::Audio) {
-				const auto document = session().data().document(file.id());
-				if (document->uploading()) {
-					const auto doneParts = file.docSentParts
-						- int(docRequestsSent.size());
-					document->uploadingData->offset = std::min(
-						document->uploadingData->size,
-						doneParts * file.docPartSize);
-				}
-				_documentProgress.fire_copy(fullId);
-			} else if (file.type() == SendMediaType::Secure) {
-				file.fileSentSize += sentPartSize;
-				_secureProgress.fire_copy({
-					fullId,
-					file.fileSentSize,
-					file.file->partssize });
-			}
+	const auto i = requestsSent.find(requestId);
+	if (i == end(requestsSent)) {
+		sendNext();
+		return;
+	}
+	const auto sent = i->second;
+	requestsSent.erase(i);
+	sentSize -= sent.size;
+	sentSizes[sent.dc] -= sent.size;
+	measureUploaded(sent.size);
+
+	const auto k = queue.find(sent.fullId);
+	Assert(k != queue.cend());
+	auto &[fullId, file] = *k;
+	--file.partsInFlight;
+	if (sent.document) {
+		--file.docPartsInFlight;
+	}
+	if (mtpIsFalse(result)) { // failed to upload this file
+		failed(fullId);
+		sendNext();
+		return;
+	}
+	if (file.type() == SendMediaType::Photo) {
+		file.fileSentSize += sent.size;
+		const auto photo = session().data().photo(file.id());
+		if (photo->uploading() && file.file) {
+			photo->uploadingData->size = file.file->partssize;
+			photo->uploadingData->offset = file.fileSentSize;
+		}
+		_photoProgress.fire_copy(fullId);
+	} else if (file.type() == SendMediaType::File
+		|| file.type() == SendMediaType::ThemeFile
+		|| file.type() == SendMediaType::Audio) {
+		const auto document = session().data().document(file.id());
+		if (document->uploading()) {
+			const auto doneParts = file.docSentParts
+				- file.docPartsInFlight;
+			document->uploadingData->offset = std::min(
+				document->uploadingData->size,
+				doneParts * file.docPartSize);
 		}
+		_documentProgress.fire_copy(fullId);
+	} else if (file.type() == SendMediaType::Secure) {
+		file.fileSentSize += sent.size;
+		_secureProgress.fire_copy({
+			fullId,
+			file.fileSentSize,
+			file.file->partssize });
 	}
 
 	sendNext();
 }
 
 void Uploader::partFailed(const MTP::Error &error, mtpRequestId requestId) {
-	// failed to upload current file
-	if ((requestsSent.find(requestId) != requestsSent.cend())
-		|| (docRequestsSent.find(requestId) != docRequestsSent.cend())) {
-		currentFailed();
+	// failed to upload this file
+	const auto i = requestsSent.find(requestId);
+	if (i != end(requestsSent)) {
+		failed(i->second.fullId);
 	}
 	sendNext();
 }
@@ -117,6 +117,20 @@ public:
 
 private:
 	struct File;
+	struct DocumentReader;
+	struct SentRequest {
+		FullMsgId fullId;
+		int32 size = 0;
+		int dc = 0;
+		bool document = false;
+	};
+
+	void readDocumentParts(const FullMsgId &msgId, File &file);
+	void documentPartRead(
+		const FullMsgId &msgId,
+		const std::shared_ptr<DocumentReader> &reader,
+		int32 index,
+		QByteArray &&bytes);
 
 	void partLoaded(const MTPBool &result, mtpRequestId requestId);
 	void partFailed(const MTP::Error &error, mtpRequestId requestId);
@@ -126,7 +140,25 @@ private:
 	void processDocumentProgress(const FullMsgId &msgId);
 	void processDocumentFailed(const FullMsgId &msgId);
 
-	void currentFailed();
+	void failed(const FullMsgId &msgId);
+	void cancelRequests(const FullMsgId &msgId);
+
+	[[nodiscard]] uint32 maxSentSize() const;
+	void finishUploaded();
+	[[nodiscard]] bool sendNextPart();
+	[[nodiscard]] bool sendPart(
+		const FullMsgId &fullId,
+		File &file,
+		int todc);
+	void partSent(
+		mtpRequestId requestId,
+		const FullMsgId &fullId,
+		File &file,
+		int32 size,
+		int dc,
+		bool document);
+	void fileUploaded(const FullMsgId &fullId, File &file);
+	void measureUploaded(int32 size);
 
 	void sendProgressUpdate(
 		not_null<HistoryItem*> item,
@@ -134,17 +166,22 @@ private:
 		int progress = 0);
 
 	const not_null<ApiWrap*> _api;
-	base::flat_map<mtpRequestId, QByteArray> requestsSent;
-	base::flat_map<mtpRequestId, int32> docRequestsSent;
-	base::flat_map<mtpRequestId, int32> dcMap;
+	base::flat_map<mtpRequestId, SentRequest> requestsSent;
 	uint32 sentSize = 0;
 	uint32 sentSizes[MTP::kUploadSessionsCount] = { 0 };
 
-	FullMsgId uploadingId;
+	int _sessionsCount = 0;
+	crl::time _rateMeasureStart = 0;
+	int64 _rateMeasureBytes = 0;
+	float64 _bytesPerMs = 0.;
+	float64 _bytesPerMsOnSessionAdd = 0.;
+	bool _windowFilled = false;
+
+	FullMsgId _lastPartOf;
 	FullMsgId _pausedId;
 	std::map<FullMsgId, File> queue;
 	std::map<FullMsgId, File> uploaded;
-	base::Timer _nextTimer, _stopSessionsTimer;
+	base::Timer _stopSessionsTimer;
 
 	rpl::event_stream<UploadedPhoto> _photoReady;
 	rpl::event_stream<UploadedDocument> _documentReady;
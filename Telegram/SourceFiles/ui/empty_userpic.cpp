@@ -19,6 +19,27 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 namespace Ui {
 namespace {
 
+// Large member lists have many peers without photos sharing the same
+// color and initials, so their circled userpics are shared by all of them.
+constexpr auto kCirclesCacheLimit = 512;
+
+struct CircleKey {
+	QString string;
+	QRgb bg = 0;
+	QRgb fg = 0;
+	int size = 0;
+
+	friend inline bool operator<(const CircleKey &a, const CircleKey &b) {
+		return std::tie(a.size, a.bg, a.fg, a.string)
+			< std::tie(b.size, b.bg, b.fg, b.string);
+	}
+};
+
+[[nodiscard]] base::flat_map<CircleKey, QPixmap> &CirclesCache() {
+	static auto result = base::flat_map<CircleKey, QPixmap>();
+	return result;
+}
+
 [[nodiscard]] bool IsExternal(const QString &name) {
 	return !name.isEmpty()
 		&& (name.front() == QChar(0))
@@ -223,9 +244,30 @@ void EmptyUserpic::paint(
 		int y,
 		int outerWidth,
 		int size) const {
-	paint(p, x, y, outerWidth, size, [&p, x, y, size] {
-		p.drawEllipse(x, y, size, size);
-	});
+	p.drawPixmapLeft(x, y, outerWidth, cachedCircle(size));
+}
+
+const QPixmap &EmptyUserpic::cachedCircle(int size) const {
+	auto key = CircleKey{
+		_string,
+		_color->c.rgba(),
+		st::historyPeerUserpicFg->c.rgba(),
+		size,
+	};
+	auto &cache = CirclesCache();
+	const auto i = cache.find(key);
+	if (i != end(cache)) {
+		return i->second;
+	} else if (cache.size() >= kCirclesCacheLimit) {
+		// Colors are a part of the key, so entries for the old palette
+		// just stay here until the next clear.
+		cache.clear();
+	}
+	return cache.emplace(std::move(key), Generate(size, [&](Painter &q) {
+		paint(q, 0, 0, size, size, [&] {
+			q.drawEllipse(0, 0, size, size);
+		});
+	})).first->second;
 }
 
 void EmptyUserpic::paintRounded(Painter &p, int x, int y, int outerWidth, int size) const {
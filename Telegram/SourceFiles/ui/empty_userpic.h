@@ -109,6 +109,7 @@ private:
 		int outerWidth,
 		int size,
 		Callback paintBackground) const;
+	[[nodiscard]] const QPixmap &cachedCircle(int size) const;
 
 	void fillString(const QString &name);
 
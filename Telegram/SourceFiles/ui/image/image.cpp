@@ -38,6 +38,21 @@ namespace {
 	return App::readImage(content, nullptr, false, nullptr);
 }
 
+struct PixCacheState {
+	base::flat_set<not_null<const Image*>> images;
+	int64 bytes = 0;
+	uint64 tick = 0;
+	int64 hits = 0;
+	int64 misses = 0;
+	bool evictionScheduled = false;
+};
+
+[[nodiscard]] PixCacheState &PixCache() {
+	// Leaked, so that static Image-s can be destroyed after it.
+	static const auto result = new PixCacheState();
+	return *result;
+}
+
 } // namespace
 
 QByteArray ExpandInlineBytes(const QByteArray &bytes) {
@@ -134,10 +149,97 @@ not_null<Image*> Image::BlankMedia() {
 	return &result;
 }
 
+Image::~Image() {
+	if (_cache.empty()) {
+		return;
+	}
+	auto &state = PixCache();
+	for (const auto &[key, cached] : _cache) {
+		state.bytes -= PixmapBytes(cached.pixmap);
+	}
+	state.images.remove(this);
+}
+
 QImage Image::original() const {
 	return _data;
 }
 
+int64 Image::PixmapBytes(const QPixmap &pixmap) {
+	return int64(pixmap.width()) * pixmap.height() * 4;
+}
+
+const QPixmap *Image::findCached(uint64 key) const {
+	auto &state = PixCache();
+	const auto i = _cache.find(key);
+	if (i == _cache.end()) {
+		++state.misses;
+		return nullptr;
+	}
+	++state.hits;
+	i->second.lastUsed = ++state.tick;
+	return &i->second.pixmap;
+}
+
+const QPixmap &Image::storeCached(uint64 key, QPixmap &&pixmap) const {
+	auto &state = PixCache();
+	auto i = _cache.find(key);
+	if (i != _cache.end()) {
+		state.bytes -= PixmapBytes(i->second.pixmap);
+		i->second.pixmap = std::move(pixmap);
+	} else {
+		i = _cache.emplace(key, CachedPixmap{ std::move(pixmap) }).first;
+		state.images.emplace(this);
+	}
+	i->second.lastUsed = ++state.tick;
+	state.bytes += PixmapBytes(i->second.pixmap);
+	if (state.bytes > kPixCacheLimit && !state.evictionScheduled) {
+		// Evict later, so that references returned from pix*() methods
+		// for the current paint stay valid.
+		state.evictionScheduled = true;
+		crl::on_main([] { EvictCached(); });
+	}
+	return i->second.pixmap;
+}
+
+void Image::EvictCached() {
+	struct Entry {
+		uint64 lastUsed = 0;
+		const Image *image = nullptr;
+		uint64 key = 0;
+	};
+	auto &state = PixCache();
+	state.evictionScheduled = false;
+	if (state.bytes <= kPixCacheLimit) {
+		return;
+	}
+	auto entries = std::vector<Entry>();
+	for (const auto image : state.images) {
+		for (const auto &[key, cached] : image->_cache) {
+			entries.push_back({ cached.lastUsed, image, key });
+		}
+	}
+	ranges::sort(entries, ranges::less(), &Entry::lastUsed);
+
+	const auto was = state.bytes;
+	for (const auto &entry : entries) {
+		if (state.bytes <= kPixCacheEvictTill) {
+			break;
+		}
+		auto &cache = entry.image->_cache;
+		const auto i = cache.find(entry.key);
+		state.bytes -= PixmapBytes(i->second.pixmap);
+		cache.erase(i);
+		if (cache.empty()) {
+			state.images.remove(entry.image);
+		}
+	}
+	DEBUG_LOG(("Image Cache: Evicted %1 of %2 bytes, hits %3, misses %4."
+		).arg(was - state.bytes
+		).arg(was
+		).arg(state.hits
+		).arg(state.misses));
+}
+
 const QPixmap &Image::pix(int w, int h) const {
 	if (w <= 0 || !width() || !height()) {
 		w = width();
@@ -147,13 +249,12 @@ const QPixmap &Image::pix(int w, int h) const {
 	}
 	auto options = Option::Smooth | Option::None;
 	auto k = PixKey(w, h, options);
-	auto i = _cache.find(k);
-	if (i == _cache.cend()) {
-		auto p = pixNoCache(w, h, options);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _cache.emplace_or_assign(k, p).first;
+	if (const auto cached = findCached(k)) {
+		return *cached;
 	}
-	return i->second;
+	auto p = pixNoCache(w, h, options);
+	p.setDevicePixelRatio(cRetinaFactor());
+	return storeCached(k, std::move(p));
 }
 
 const QPixmap &Image::pixRounded(
@@ -182,13 +283,12 @@ const QPixmap &Image::pixRounded(
 		options |= Option::Circled | cornerOptions(corners);
 	}
 	auto k = PixKey(w, h, options);
-	auto i = _cache.find(k);
-	if (i == _cache.cend()) {
-		auto p = pixNoCache(w, h, options);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _cache.emplace_or_assign(k, p).first;
+	if (const auto cached = findCached(k)) {
+		return *cached;
 	}
-	return i->second;
+	auto p = pixNoCache(w, h, options);
+	p.setDevicePixelRatio(cRetinaFactor());
+	return storeCached(k, std::move(p));
 }
 
 const QPixmap &Image::pixCircled(int w, int h) const {
@@ -200,13 +300,12 @@ const QPixmap &Image::pixCircled(int w, int h) const {
 	}
 	auto options = Option::Smooth | Option::Circled;
 	auto k = PixKey(w, h, options);
-	auto i = _cache.find(k);
-	if (i == _cache.cend()) {
-		auto p = pixNoCache(w, h, options);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _cache.emplace_or_assign(k, p).first;
+	if (const auto cached = findCached(k)) {
+		return *cached;
 	}
-	return i->second;
+	auto p = pixNoCache(w, h, options);
+	p.setDevicePixelRatio(cRetinaFactor());
+	return storeCached(k, std::move(p));
 }
 
 const QPixmap &Image::pixBlurredCircled(int w, int h) const {
@@ -218,13 +317,12 @@ const QPixmap &Image::pixBlurredCircled(int w, int h) const {
 	}
 	auto options = Option::Smooth | Option::Circled | Option::Blurred;
 	auto k = PixKey(w, h, options);
-	auto i = _cache.find(k);
-	if (i == _cache.cend()) {
-		auto p = pixNoCache(w, h, options);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _cache.emplace_or_assign(k, p).first;
+	if (const auto cached = findCached(k)) {
+		return *cached;
 	}
-	return i->second;
+	auto p = pixNoCache(w, h, options);
+	p.setDevicePixelRatio(cRetinaFactor());
+	return storeCached(k, std::move(p));
 }
 
 const QPixmap &Image::pixBlurred(int w, int h) const {
@@ -236,13 +334,12 @@ const QPixmap &Image::pixBlurred(int w, int h) const {
 	}
 	auto options = Option::Smooth | Option::Blurred;
 	auto k = PixKey(w, h, options);
-	auto i = _cache.find(k);
-	if (i == _cache.cend()) {
-		auto p = pixNoCache(w, h, options);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _cache.emplace_or_assign(k, p).first;
+	if (const auto cached = findCached(k)) {
+		return *cached;
 	}
-	return i->second;
+	auto p = pixNoCache(w, h, options);
+	p.setDevicePixelRatio(cRetinaFactor());
+	return storeCached(k, std::move(p));
 }
 
 const QPixmap &Image::pixColored(style::color add, int w, int h) const {
@@ -254,13 +351,12 @@ const QPixmap &Image::pixColored(style::color add, int w, int h) const {
 	}
 	auto options = Option::Smooth | Option::Colored;
 	auto k = PixKey(w, h, options);
-	auto i = _cache.find(k);
-	if (i == _cache.cend()) {
-		auto p = pixColoredNoCache(add, w, h, true);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _cache.emplace_or_assign(k, p).first;
+	if (const auto cached = findCached(k)) {
+		return *cached;
 	}
-	return i->second;
+	auto p = pixColoredNoCache(add, w, h, true);
+	p.setDevicePixelRatio(cRetinaFactor());
+	return storeCached(k, std::move(p));
 }
 
 const QPixmap &Image::pixBlurredColored(
@@ -275,13 +371,12 @@ const QPixmap &Image::pixBlurredColored(
 	}
 	auto options = Option::Blurred | Option::Smooth | Option::Colored;
 	auto k = PixKey(w, h, options);
-	auto i = _cache.find(k);
-	if (i == _cache.cend()) {
-		auto p = pixBlurredColoredNoCache(add, w, h);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _cache.emplace_or_assign(k, p).first;
+	if (const auto cached = findCached(k)) {
+		return *cached;
 	}
-	return i->second;
+	auto p = pixBlurredColoredNoCache(add, w, h);
+	p.setDevicePixelRatio(cRetinaFactor());
+	return storeCached(k, std::move(p));
 }
 
 const QPixmap &Image::pixSingle(
@@ -318,13 +413,15 @@ const QPixmap &Image::pixSingle(
 	}
 
 	auto k = SinglePixKey(options);
-	auto i = _cache.find(k);
-	if (i == _cache.cend() || i->second.width() != (outerw * cIntRetinaFactor()) || i->second.height() != (outerh * cIntRetinaFactor())) {
-		auto p = pixNoCache(w, h, options, outerw, outerh, colored);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _cache.emplace_or_assign(k, p).first;
+	const auto cached = findCached(k);
+	if (cached
+		&& cached->width() == (outerw * cIntRetinaFactor())
+		&& cached->height() == (outerh * cIntRetinaFactor())) {
+		return *cached;
 	}
-	return i->second;
+	auto p = pixNoCache(w, h, options, outerw, outerh, colored);
+	p.setDevicePixelRatio(cRetinaFactor());
+	return storeCached(k, std::move(p));
 }
 
 const QPixmap &Image::pixBlurredSingle(
@@ -361,13 +458,15 @@ const QPixmap &Image::pixBlurredSingle(
 	}
 
 	auto k = SinglePixKey(options);
-	auto i = _cache.find(k);
-	if (i == _cache.cend() || i->second.width() != (outerw * cIntRetinaFactor()) || i->second.height() != (outerh * cIntRetinaFactor())) {
-		auto p = pixNoCache(w, h, options, outerw, outerh, colored);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _cache.emplace_or_assign(k, p).first;
+	const auto cached = findCached(k);
+	if (cached
+		&& cached->width() == (outerw * cIntRetinaFactor())
+		&& cached->height() == (outerh * cIntRetinaFactor())) {
+		return *cached;
 	}
-	return i->second;
+	auto p = pixNoCache(w, h, options, outerw, outerh, colored);
+	p.setDevicePixelRatio(cRetinaFactor());
+	return storeCached(k, std::move(p));
 }
 
 QPixmap Image::pixNoCache(
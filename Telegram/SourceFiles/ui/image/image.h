@@ -21,6 +21,9 @@ public:
 	explicit Image(const QString &path);
 	explicit Image(const QByteArray &content);
 	explicit Image(QImage &&data);
+	Image(const Image &other) = delete;
+	Image &operator=(const Image &other) = delete;
+	~Image();
 
 	[[nodiscard]] static not_null<Image*> Empty(); // 1x1 transparent
 	[[nodiscard]] static not_null<Image*> BlankMedia(); // 1x1 black
@@ -89,7 +92,23 @@ public:
 		int h = 0) const;
 
 private:
+	struct CachedPixmap {
+		QPixmap pixmap;
+		uint64 lastUsed = 0;
+	};
+
+	// Scaled pixmaps of all images share a common size limit,
+	// the least recently used ones are evicted when it is exceeded.
+	static constexpr auto kPixCacheLimit = int64(192 * 1024 * 1024);
+	static constexpr auto kPixCacheEvictTill = kPixCacheLimit * 3 / 4;
+
+	[[nodiscard]] static int64 PixmapBytes(const QPixmap &pixmap);
+	static void EvictCached();
+
+	[[nodiscard]] const QPixmap *findCached(uint64 key) const;
+	const QPixmap &storeCached(uint64 key, QPixmap &&pixmap) const;
+
 	const QImage _data;
-	mutable base::flat_map<uint64, QPixmap> _cache;
+	mutable base::flat_map<uint64, CachedPixmap> _cache;
 
 };